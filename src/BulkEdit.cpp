@@ -0,0 +1,262 @@
+#include "BulkEdit.h"
+#include "ConfigurationManager.h"
+#include "TaskRuntime.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const JOURNAL_DIR = "designs/.bulkedit";
+// Written once every original is copied and flushed; without it a journal
+// may hold torn copies, and no design has been touched yet.
+const char* const JOURNALED_MARKER = "designs/.bulkedit/JOURNALED";
+const char* const COMMIT_MARKER = "designs/.bulkedit/COMMITTED";
+// Not .f1design, so directory scans and counts never pick the copies up.
+const char* const JOURNAL_EXTENSION = ".f1backup";
+
+fs::path designPath(const std::string& name) {
+    return fs::path("designs") / (name + ".f1design");
+}
+
+fs::path journalPath(const std::string& name) {
+    return fs::path(JOURNAL_DIR) / (name + JOURNAL_EXTENSION);
+}
+
+const size_t SCAN_BLOCK = 256;  // designs loaded and matched per work item
+
+#if !defined(_WIN32) && !defined(__linux__)
+void syncPath(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    bool synced = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!synced) throw std::runtime_error("Failed to flush " + path.string() + " to disk");
+}
+#endif
+
+// Flushes files, and the directory entries naming them, to disk. On Linux a
+// single syncfs() covers the whole file system, cheaper than a sync per file.
+// A no-op on Windows.
+void syncDesigns([[maybe_unused]] const std::vector<fs::path>& files, [[maybe_unused]] size_t threads) {
+#if defined(__linux__)
+    int fd = ::open("designs", O_RDONLY | O_DIRECTORY);
+    bool synced = fd >= 0 && ::syncfs(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!synced) throw std::runtime_error("Failed to flush designs to disk");
+#elif !defined(_WIN32)
+    ThreadPoolExecutor::shared().parallelFor(files.size(), threads, [&](size_t i) { syncPath(files[i]); });
+    if (fs::exists(JOURNAL_DIR)) syncPath(JOURNAL_DIR);
+    syncPath("designs");
+#endif
+}
+
+void writeMarker(const char* path, size_t threads) {
+    {
+        std::ofstream marker(path);
+        if (!marker.is_open()) throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+    syncDesigns({path}, threads);
+}
+
+void commitChanges(const std::vector<BulkEditChange>& changes, size_t threads, int64_t crashAfter) {
+    TRACE_ZONE("BulkEdit commit");
+    std::vector<fs::path> journal, written;
+    for (const auto& change : changes) {
+        journal.push_back(journalPath(change.name));
+        written.push_back(designPath(change.name));
+    }
+    try {
+        fs::create_directories(JOURNAL_DIR);
+        ThreadPoolExecutor::shared().parallelFor(changes.size(), threads, [&](size_t i) {
+            ConfigurationManager::backupDesign(changes[i].name);
+            fs::copy_file(designPath(changes[i].name), journal[i], fs::copy_options::overwrite_existing);
+        });
+        // Nothing is overwritten until every original copy is on disk.
+        syncDesigns(journal, threads);
+        writeMarker(JOURNALED_MARKER, threads);
+    } catch (const std::exception& e) {
+        std::error_code ignored;
+        fs::remove_all(JOURNAL_DIR, ignored);
+        throw std::runtime_error(std::string("Bulk edit aborted, no designs were changed: ") + e.what());
+    }
+
+    std::atomic<int64_t> writes{0};
+    try {
+        ThreadPoolExecutor::shared().parallelFor(changes.size(), threads, [&](size_t i) {
+            if (crashAfter >= 0 && writes.fetch_add(1, std::memory_order_relaxed) >= crashAfter) std::abort();
+            CarDesign design;
+            design.setParameters(changes[i].after);
+            design.saveToFile(changes[i].name);
+        });
+        syncDesigns(written, threads);
+        writeMarker(COMMIT_MARKER, threads);
+    } catch (const std::exception& e) {
+        // The marker may exist if writing or flushing it failed; the edit is
+        // rolled back all the same, so recovery must not take it as committed.
+        std::error_code ignored;
+        fs::remove(COMMIT_MARKER, ignored);
+        BulkEdit::recoverInterrupted();
+        throw std::runtime_error(std::string("Bulk edit rolled back, no designs were changed: ") + e.what());
+    }
+
+    // Committed: the rest only brings the version histories and the index up to date.
+    ThreadPoolExecutor::shared().parallelFor(changes.size(), threads, [&](size_t i) { ConfigurationManager::recordVersion(changes[i].name); });
+    // Removing the journal moves the directory time, so it goes before the
+    // index records the new one.
+    std::error_code ignored;
+    fs::remove_all(JOURNAL_DIR, ignored);
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    std::vector<std::pair<std::string, DesignParameters>> upserts;
+    upserts.reserve(changes.size());
+    for (const auto& change : changes) upserts.emplace_back(change.name, change.after);
+    try {
+        index.upsert(upserts);
+    } catch (const std::exception& e) {
+        index.invalidate();
+    }
+}
+
+}
+
+bool BulkEdit::parseAction(BulkOperation operation, const std::string& text, BulkAction& action) {
+    size_t equals = text.find('=');
+    if (equals == std::string::npos || equals == 0) return false;
+    if (!LibraryIndex::parseColumn(text.substr(0, equals), action.column)) return false;
+    if (action.column > IndexColumn::SIDEPODS_AERO) return false;
+    const char* valueText = text.c_str() + equals + 1;
+    char* end = nullptr;
+    action.value = std::strtod(valueText, &end);
+    if (end == valueText || *end) return false;
+    bool partColumn = action.column < IndexColumn::FRONT_WING_AERO;
+    if (partColumn && operation != BulkOperation::SET) return false;
+    action.operation = operation;
+    return true;
+}
+
+DesignParameters BulkEdit::applyActions(const std::vector<BulkAction>& actions, DesignParameters params) {
+    const int counts[4] = {FrontWing::getDesignCount(), RearWing::getDesignCount(), Diffuser::getDesignCount(),
+                           Sidepods::getDesignCount()};
+    for (const auto& action : actions) {
+        int column = static_cast<int>(action.column);
+        if (column < 4) {
+            int index = static_cast<int>(action.value);
+            if (index != action.value || index < 0 || index >= counts[column]) {
+                char message[96];
+                std::snprintf(message, sizeof(message), "No %s design %g", LibraryIndex::columnName(action.column), action.value);
+                throw std::invalid_argument(message);
+            }
+            params.parts[column] = index;
+            continue;
+        }
+        double& aero = params.aero[column - 4];
+        switch (action.operation) {
+        case BulkOperation::SET: aero = action.value; break;
+        case BulkOperation::CAP: aero = std::min(aero, action.value); break;
+        case BulkOperation::FLOOR: aero = std::max(aero, action.value); break;
+        case BulkOperation::SCALE: aero *= action.value; break;
+        }
+        aero = std::clamp(aero, 0.5, 1.5);
+    }
+    return params;
+}
+
+bool BulkEdit::recoverInterrupted() {
+    std::error_code error;
+    if (!fs::exists(JOURNAL_DIR, error)) return false;
+    bool recovered = false;
+    try {
+        if (fs::exists(COMMIT_MARKER)) {
+            // Every design was written; only the index may have missed some.
+            ConfigurationManager::getLibraryIndex().rebuild();
+            recovered = true;
+        } else if (fs::exists(JOURNALED_MARKER)) {
+            for (const auto& entry : fs::directory_iterator(JOURNAL_DIR)) {
+                if (entry.path().extension() != JOURNAL_EXTENSION) continue;
+                fs::copy_file(entry.path(), designPath(entry.path().stem().string()), fs::copy_options::overwrite_existing);
+            }
+            recovered = true;
+        }
+        // Otherwise the journal was still being written: every design is
+        // intact and the copies may not be, so they are simply discarded.
+        fs::remove_all(JOURNAL_DIR);
+    } catch (const std::exception& e) {
+        throw std::runtime_error(std::string("Failed to recover interrupted bulk edit in ") + JOURNAL_DIR + ": " + e.what());
+    }
+    return recovered;
+}
+
+BulkEditReport BulkEdit::run(const BulkEditSpec& spec) {
+    TRACE_ZONE("BulkEdit::run");
+    auto start = std::chrono::steady_clock::now();
+    ConfigurationManager::ensureDesignsDirectory();
+    BulkEditReport report;
+    report.recovered = recoverInterrupted();
+
+    enum class Outcome : uint8_t { UNREADABLE, FILTERED, MATCHED };
+    // Each block's results are allocated by the worker that fills them.
+    struct ScanBlock {
+        std::vector<Outcome> outcomes;
+        std::vector<DesignParameters> before, after;
+    };
+    std::vector<std::string> names = ConfigurationManager::getDesignFiles();
+    std::vector<ScanBlock> blocks((names.size() + SCAN_BLOCK - 1) / SCAN_BLOCK);
+    ThreadPoolExecutor::shared().parallelFor(blocks.size(), spec.threads, [&](size_t b) {
+        size_t begin = b * SCAN_BLOCK;
+        size_t count = std::min(SCAN_BLOCK, names.size() - begin);
+        ScanBlock block;
+        block.outcomes.assign(count, Outcome::FILTERED);
+        block.before.resize(count);
+        block.after.resize(count);
+        CarDesign design;
+        for (size_t j = 0; j < count; ++j) {
+            try {
+                design.loadFromFile(names[begin + j]);
+            } catch (const std::exception& e) {
+                // Skip corrupted files
+                block.outcomes[j] = Outcome::UNREADABLE;
+                continue;
+            }
+            block.before[j] = design.getParameters();
+            if (!LibraryIndex::matches(spec.filter, block.before[j])) continue;
+            block.outcomes[j] = Outcome::MATCHED;
+            try {
+                block.after[j] = applyActions(spec.actions, block.before[j]);
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(names[begin + j] + ": " + e.what());
+            }
+        }
+        blocks[b] = std::move(block);
+    });
+
+    report.scanned = names.size();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const ScanBlock& block = blocks[b];
+        for (size_t j = 0; j < block.outcomes.size(); ++j) {
+            if (block.outcomes[j] == Outcome::UNREADABLE) ++report.unreadable;
+            if (block.outcomes[j] != Outcome::MATCHED) continue;
+            ++report.matched;
+            if (block.after[j] == block.before[j]) continue;
+            report.changes.push_back({names[b * SCAN_BLOCK + j], block.before[j], block.after[j],
+                                      CarDesign::evaluate(block.before[j]), CarDesign::evaluate(block.after[j])});
+        }
+    }
+    if (!spec.dryRun && !report.changes.empty()) {
+        commitChanges(report.changes, spec.threads, spec.crashAfter);
+        report.committed = true;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,71 @@
+#ifndef BULKEDIT_H
+#define BULKEDIT_H
+
+#include "CarDesign.h"
+#include "LibraryIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class BulkOperation { SET, CAP, FLOOR, SCALE };
+
+// One change to a parameter column (FRONT_WING .. SIDEPODS_AERO) of every
+// matched design. Part columns only support SET.
+struct BulkAction {
+    BulkOperation operation{BulkOperation::SET};
+    IndexColumn column{IndexColumn::FRONT_WING};
+    double value{0.0};
+};
+
+struct BulkEditSpec {
+    std::vector<IndexPredicate> filter;  // every predicate must hold, as in index queries
+    std::vector<BulkAction> actions;     // applied in order
+    bool dryRun{false};
+    size_t threads{0};                   // 0 uses every compute pool worker
+    int64_t crashAfter{-1};              // fault injection: the commit aborts the process after this many writes
+};
+
+struct BulkEditChange {
+    std::string name;
+    DesignParameters before;
+    DesignParameters after;
+    DesignMetrics beforeMetrics;
+    DesignMetrics afterMetrics;
+};
+
+struct BulkEditReport {
+    size_t scanned{0};
+    size_t matched{0};
+    size_t unreadable{0};
+    std::vector<BulkEditChange> changes;  // matched designs the actions changed, by name
+    bool recovered{false};                // an interrupted commit was rolled back or finished first
+    bool committed{false};
+    double seconds{0.0};
+};
+
+// Applies actions to every saved design that passes a filter, all or
+// nothing. Designs are loaded, matched and transformed on all cores; the
+// changed ones are then committed in parallel behind a rollback journal in
+// designs/.bulkedit: originals are copied there (after the usual version
+// backup) and marked complete before any design is overwritten, and copied
+// back if any write fails or the process dies before the commit marker is
+// written. A journal that was never marked complete is discarded instead,
+// since no design had been touched. On POSIX systems the journal is flushed
+// to disk before the first overwrite and the new designs before the commit
+// marker, so this also holds across a power loss; on Windows only a crash of
+// the process is covered.
+class BulkEdit {
+public:
+    // Parses "COLUMN=VALUE", e.g. "rearwing=2" or "frontwingaero=1.2".
+    static bool parseAction(BulkOperation operation, const std::string& text, BulkAction& action);
+    // Throws std::invalid_argument if an action leaves a part index outside its catalog.
+    static DesignParameters applyActions(const std::vector<BulkAction>& actions, DesignParameters params);
+
+    static BulkEditReport run(const BulkEditSpec& spec);
+    // Restores the designs of an interrupted commit, or finishes one that
+    // was committed; run() calls this first. Returns true if it did either.
+    static bool recoverInterrupted();
+};
+
+#endif
@@ -1,10 +1,13 @@
 #include "CarDesign.h"
+#include "TraceRecorder.h"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <regex>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
 
 const std::map<int, PartAttributes> FrontWing::designs = {
     {0, {10.0, 5.0, 10000.0}},  // Standard
@@ -26,6 +29,8 @@ void FrontWing::setDesign(int designIndex) {
 }
 int FrontWing::getSelectedDesign() const { return selectedDesign; }
 std::string FrontWing::getDesignName() const { return designNames.at(selectedDesign); }
+PartAttributes FrontWing::getDesignAttributes(int designIndex) { return designs.at(designIndex); }
+int FrontWing::getDesignCount() { return static_cast<int>(designs.size()); }
 
 const std::map<int, PartAttributes> RearWing::designs = {
     {0, {15.0, 6.0, 15000.0}},
@@ -47,6 +52,8 @@ void RearWing::setDesign(int designIndex) {
 }
 int RearWing::getSelectedDesign() const { return selectedDesign; }
 std::string RearWing::getDesignName() const { return designNames.at(selectedDesign); }
+PartAttributes RearWing::getDesignAttributes(int designIndex) { return designs.at(designIndex); }
+int RearWing::getDesignCount() { return static_cast<int>(designs.size()); }
 
 const std::map<int, PartAttributes> Diffuser::designs = {
     {0, {5.0, 3.0, 8000.0}},
@@ -68,6 +75,8 @@ void Diffuser::setDesign(int designIndex) {
 }
 int Diffuser::getSelectedDesign() const { return selectedDesign; }
 std::string Diffuser::getDesignName() const { return designNames.at(selectedDesign); }
+PartAttributes Diffuser::getDesignAttributes(int designIndex) { return designs.at(designIndex); }
+int Diffuser::getDesignCount() { return static_cast<int>(designs.size()); }
 
 const std::map<int, PartAttributes> Sidepods::designs = {
     {0, {8.0, 10.0, 20000.0}},
@@ -89,16 +98,22 @@ void Sidepods::setDesign(int designIndex) {
 }
 int Sidepods::getSelectedDesign() const { return selectedDesign; }
 std::string Sidepods::getDesignName() const { return designNames.at(selectedDesign); }
+PartAttributes Sidepods::getDesignAttributes(int designIndex) { return designs.at(designIndex); }
+int Sidepods::getDesignCount() { return static_cast<int>(designs.size()); }
 
-CarDesign::CarDesign() {
+CarDesign::CarDesign() : CarDesign(std::pmr::get_default_resource()) {}
+CarDesign::CarDesign(std::pmr::memory_resource* resource)
+    : frontWing(resource), rearWing(resource), diffuser(resource), sidepods(resource), aeroEfficiencies(resource) {
     aeroEfficiencies[FRONT_WING] = 1.0;
     aeroEfficiencies[REAR_WING] = 1.0;
     aeroEfficiencies[DIFFUSER] = 1.0;
     aeroEfficiencies[SIDEPODS] = 1.0;
 }
 CarDesign::~CarDesign() = default;
-CarDesign::CarDesign(const CarDesign& other)
-    : frontWing(), rearWing(), diffuser(), sidepods(), aeroEfficiencies(other.aeroEfficiencies) {
+CarDesign::CarDesign(const CarDesign& other) : CarDesign(other, std::pmr::get_default_resource()) {}
+CarDesign::CarDesign(const CarDesign& other, std::pmr::memory_resource* resource)
+    : frontWing(resource), rearWing(resource), diffuser(resource), sidepods(resource),
+      aeroEfficiencies(other.aeroEfficiencies, resource) {
     frontWing.getPart()->setDesign(other.frontWing.getPart()->getSelectedDesign());
     rearWing.getPart()->setDesign(other.rearWing.getPart()->getSelectedDesign());
     diffuser.getPart()->setDesign(other.diffuser.getPart()->getSelectedDesign());
@@ -145,14 +160,26 @@ PartAttributes CarDesign::getTotalAttributes() const {
            sidepods.getPart()->getAttributes();
 }
 double CarDesign::getFuelConsumption() const {
-    auto attrs = getTotalAttributes();
-    return 0.15 * attrs.mass + 0.25 * attrs.drag + 5.0; // Realistic fuel model
+    return evaluate(getTotalAttributes()).fuelConsumption;
 }
 double CarDesign::getSpeed() const {
-    auto attrs = getTotalAttributes();
-    return 15000.0 / (attrs.drag + 0.05 * attrs.mass); // Speed model
+    return evaluate(getTotalAttributes()).speed;
+}
+DesignMetrics CarDesign::evaluate(const DesignParameters& params) {
+    return evaluate(FrontWing::getDesignAttributes(params.parts[0]) * std::clamp(params.aero[0], 0.5, 1.5) +
+                    RearWing::getDesignAttributes(params.parts[1]) * std::clamp(params.aero[1], 0.5, 1.5) +
+                    Diffuser::getDesignAttributes(params.parts[2]) * std::clamp(params.aero[2], 0.5, 1.5) +
+                    Sidepods::getDesignAttributes(params.parts[3]) * std::clamp(params.aero[3], 0.5, 1.5));
+}
+DesignMetrics CarDesign::evaluate(const PartAttributes& totals) {
+    DesignMetrics metrics;
+    metrics.attributes = totals;
+    metrics.fuelConsumption = 0.15 * totals.mass + 0.25 * totals.drag + 5.0; // Realistic fuel model
+    metrics.speed = speedModel(totals.drag, totals.mass);
+    return metrics;
 }
 void CarDesign::saveToFile(const std::string& filename) const {
+    TRACE_ZONE("CarDesign::saveToFile");
     auto [isValid, error] = validateDesignName(filename);
     if (!isValid) {
         throw std::invalid_argument(error);
@@ -168,43 +195,82 @@ void CarDesign::saveToFile(const std::string& filename) const {
     file << "DiffuserAero: " << aeroEfficiencies.at(DIFFUSER) << "\n";
     file << "SidepodsAero: " << aeroEfficiencies.at(SIDEPODS) << "\n";
     file.close();
+    // Catches short writes (a full disk, an I/O error) as well as the flush on close.
+    if (!file) throw std::runtime_error("Failed to save design");
 }
-void CarDesign::loadFromFile(const std::string& filename) {
-    std::ifstream file("designs/" + filename + ".f1design");
+void CarDesign::loadFromFile(std::string_view filename) {
+    TRACE_ZONE("CarDesign::loadFromFile");
+    // Parses without touching the global heap: the path is built in a stack
+    // arena and the stream reads through a stack buffer. Overlong paths and
+    // lines spill into the design's own memory resource.
+    static const char* const keys[8] = {"FrontWing", "RearWing", "Diffuser", "Sidepods",
+                                        "FrontWingAero", "RearWingAero", "DiffuserAero", "SidepodsAero"};
+    char pathStorage[256];
+    std::pmr::monotonic_buffer_resource pathArena(pathStorage, sizeof(pathStorage), getMemoryResource());
+    std::pmr::string path("designs/", &pathArena);
+    path += filename;
+    path += ".f1design";
+    char streamBuffer[1024];
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(streamBuffer, sizeof(streamBuffer));
+    file.open(path.c_str());
     if (!file.is_open()) throw std::runtime_error("Failed to load design");
-    std::string line;
-    std::map<std::string, double> values;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        double value;
-        if (!(std::getline(iss, key, ':') && iss >> value)) {
+    char lineBuffer[256];
+    std::pmr::string longLine(getMemoryResource());
+    double values[8];
+    bool found[8] = {false, false, false, false, false, false, false, false};
+    while (true) {
+        char* line = lineBuffer;
+        if (!file.getline(lineBuffer, sizeof(lineBuffer))) {
+            if (file.eof() || file.bad()) break;
+            // The line did not fit the buffer: read the rest of it into the resource
+            file.clear();
+            std::pmr::string rest(getMemoryResource());
+            std::getline(file, rest);
+            longLine.assign(lineBuffer);
+            longLine += rest;
+            line = longLine.data();
+        }
+        char* colon = std::strchr(line, ':');
+        char* end = nullptr;
+        double value = colon ? std::strtod(colon + 1, &end) : 0.0;
+        if (!colon || end == colon + 1) {
             file.close();
             throw std::runtime_error("Corrupted design file");
         }
-        values[key] = value;
+        *colon = '\0';
+        for (int field = 0; field < 8; ++field) {
+            if (std::strcmp(line, keys[field]) == 0) {
+                values[field] = value;
+                found[field] = true;
+            }
+        }
+    }
+    if (!file.eof()) {
+        file.close();
+        throw std::runtime_error("Corrupted design file");
     }
     file.close();
     try {
-        if (values.find("FrontWing") != values.end()) frontWing.getPart()->setDesign(static_cast<int>(values["FrontWing"]));
-        if (values.find("RearWing") != values.end()) rearWing.getPart()->setDesign(static_cast<int>(values["RearWing"]));
-        if (values.find("Diffuser") != values.end()) diffuser.getPart()->setDesign(static_cast<int>(values["Diffuser"]));
-        if (values.find("Sidepods") != values.end()) sidepods.getPart()->setDesign(static_cast<int>(values["Sidepods"]));
-        if (values.find("FrontWingAero") != values.end()) {
-            aeroEfficiencies[FRONT_WING] = values["FrontWingAero"];
-            frontWing.getPart()->adjustAeroEfficiency(values["FrontWingAero"]);
+        if (found[0]) frontWing.getPart()->setDesign(static_cast<int>(values[0]));
+        if (found[1]) rearWing.getPart()->setDesign(static_cast<int>(values[1]));
+        if (found[2]) diffuser.getPart()->setDesign(static_cast<int>(values[2]));
+        if (found[3]) sidepods.getPart()->setDesign(static_cast<int>(values[3]));
+        if (found[4]) {
+            aeroEfficiencies[FRONT_WING] = values[4];
+            frontWing.getPart()->adjustAeroEfficiency(values[4]);
         }
-        if (values.find("RearWingAero") != values.end()) {
-            aeroEfficiencies[REAR_WING] = values["RearWingAero"];
-            rearWing.getPart()->adjustAeroEfficiency(values["RearWingAero"]);
+        if (found[5]) {
+            aeroEfficiencies[REAR_WING] = values[5];
+            rearWing.getPart()->adjustAeroEfficiency(values[5]);
         }
-        if (values.find("DiffuserAero") != values.end()) {
-            aeroEfficiencies[DIFFUSER] = values["DiffuserAero"];
-            diffuser.getPart()->adjustAeroEfficiency(values["DiffuserAero"]);
+        if (found[6]) {
+            aeroEfficiencies[DIFFUSER] = values[6];
+            diffuser.getPart()->adjustAeroEfficiency(values[6]);
         }
-        if (values.find("SidepodsAero") != values.end()) {
-            aeroEfficiencies[SIDEPODS] = values["SidepodsAero"];
-            sidepods.getPart()->adjustAeroEfficiency(values["SidepodsAero"]);
+        if (found[7]) {
+            aeroEfficiencies[SIDEPODS] = values[7];
+            sidepods.getPart()->adjustAeroEfficiency(values[7]);
         }
     } catch (const std::exception& e) {
         throw std::runtime_error("Invalid design data");
@@ -243,6 +309,7 @@ std::string CarDesign::getVisualRepresentation() const {
     return ss.str();
 }
 std::pair<bool, std::string> CarDesign::validateDesignName(const std::string& name) {
+    TRACE_ZONE("CarDesign::validateDesignName");
     std::string trimmed = name;
     trimmed.erase(trimmed.begin(), std::find_if(trimmed.begin(), trimmed.end(), [](unsigned char c) { return !std::isspace(c); }));
     trimmed.erase(std::find_if(trimmed.rbegin(), trimmed.rend(), [](unsigned char c) { return !std::isspace(c); }).base(), trimmed.end());
@@ -279,4 +346,18 @@ void CarDesign::adjustAeroEfficiency(PartType type, double factor) {
 }
 double CarDesign::getAeroEfficiency(PartType type) const {
     return aeroEfficiencies.at(type);
+}
+DesignParameters CarDesign::getParameters() const {
+    DesignParameters params;
+    for (int i = 0; i < 4; ++i) {
+        params.parts[i] = getPartDesign(ALL_PART_TYPES[i]);
+        params.aero[i] = aeroEfficiencies.at(ALL_PART_TYPES[i]);
+    }
+    return params;
+}
+void CarDesign::setParameters(const DesignParameters& params) {
+    for (int i = 0; i < 4; ++i) {
+        setPartDesign(ALL_PART_TYPES[i], params.parts[i]);
+        adjustAeroEfficiency(ALL_PART_TYPES[i], params.aero[i]);
+    }
 }
\ No newline at end of file
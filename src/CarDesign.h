@@ -4,8 +4,11 @@
 #include "CarPart.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
 #include <map>
+#include <new>
 #include <utility>
 
 enum PartType {
@@ -16,14 +19,45 @@ enum PartType {
     SIDEPODS = 1 << 3
 };
 
+// Part order shared by the UI selection arrays and DesignParameters.
+constexpr PartType ALL_PART_TYPES[4] = {FRONT_WING, REAR_WING, DIFFUSER, SIDEPODS};
+
+// Plain value form of a design: one catalog index and one aero factor per part,
+// in ALL_PART_TYPES order.
+struct DesignParameters {
+    int parts[4]{0, 0, 0, 0};
+    double aero[4]{1.0, 1.0, 1.0, 1.0};
+    bool operator==(const DesignParameters& other) const {
+        for (int i = 0; i < 4; ++i) {
+            if (parts[i] != other.parts[i] || aero[i] != other.aero[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const DesignParameters& other) const { return !(*this == other); }
+};
+
+// Owns one part allocated from a memory resource; the part is returned to the
+// same resource it came from, even after the manager has been moved.
 template<typename T>
 class PartManager {
 public:
-    PartManager() : part(std::make_unique<T>()) {}
+    explicit PartManager(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : part(create(resource)) {}
     T* getPart() { return part.get(); }
     const T* getPart() const { return part.get(); }
 private:
-    std::unique_ptr<T> part;
+    struct Deleter {
+        std::pmr::memory_resource* resource;
+        void operator()(T* p) const {
+            p->~T();
+            resource->deallocate(p, sizeof(T), alignof(T));
+        }
+    };
+    static std::unique_ptr<T, Deleter> create(std::pmr::memory_resource* resource) {
+        void* memory = resource->allocate(sizeof(T), alignof(T));
+        return std::unique_ptr<T, Deleter>(new (memory) T(), Deleter{resource});
+    }
+    std::unique_ptr<T, Deleter> part;
 };
 
 class FrontWing : public AeroPart {
@@ -34,6 +68,8 @@ public:
     int getSelectedDesign() const override;
     std::string getDesignName() const override;
     std::string getPartType() const override { return "FrontWing"; }
+    static PartAttributes getDesignAttributes(int designIndex);
+    static int getDesignCount();
 private:
     int selectedDesign;
     static const std::map<int, PartAttributes> designs;
@@ -48,6 +84,8 @@ public:
     int getSelectedDesign() const override;
     std::string getDesignName() const override;
     std::string getPartType() const override { return "RearWing"; }
+    static PartAttributes getDesignAttributes(int designIndex);
+    static int getDesignCount();
 private:
     int selectedDesign;
     static const std::map<int, PartAttributes> designs;
@@ -62,6 +100,8 @@ public:
     int getSelectedDesign() const override;
     std::string getDesignName() const override;
     std::string getPartType() const override { return "Diffuser"; }
+    static PartAttributes getDesignAttributes(int designIndex);
+    static int getDesignCount();
 private:
     int selectedDesign;
     static const std::map<int, PartAttributes> designs;
@@ -76,17 +116,27 @@ public:
     int getSelectedDesign() const override;
     std::string getDesignName() const override;
     std::string getPartType() const override { return "Sidepods"; }
+    static PartAttributes getDesignAttributes(int designIndex);
+    static int getDesignCount();
 private:
     int selectedDesign;
     static const std::map<int, PartAttributes> designs;
     static const std::map<int, std::string> designNames;
 };
 
+struct DesignMetrics {
+    PartAttributes attributes;
+    double speed{0.0};
+    double fuelConsumption{0.0};
+};
+
 class CarDesign {
 public:
     CarDesign();
+    explicit CarDesign(std::pmr::memory_resource* resource);
     ~CarDesign();
     CarDesign(const CarDesign& other);
+    CarDesign(const CarDesign& other, std::pmr::memory_resource* resource);
     CarDesign(CarDesign&& other) noexcept;
     CarDesign& operator=(const CarDesign& other);
     CarDesign& operator=(CarDesign&& other) noexcept;
@@ -94,7 +144,8 @@ public:
     double getFuelConsumption() const;
     double getSpeed() const;
     void saveToFile(const std::string& filename) const;
-    void loadFromFile(const std::string& filename);
+    // Takes a view so batch callers can pass names held in their own arena.
+    void loadFromFile(std::string_view filename);
     void setPartDesign(PartType type, int designIndex);
     std::string getPartDesignName(PartType type) const;
     int getPartDesign(PartType type) const;
@@ -102,12 +153,23 @@ public:
     static std::pair<bool, std::string> validateDesignName(const std::string& name);
     void adjustAeroEfficiency(PartType type, double factor);
     double getAeroEfficiency(PartType type) const;
+    DesignParameters getParameters() const;
+    void setParameters(const DesignParameters& params);
+    // Same results as getTotalAttributes/getSpeed/getFuelConsumption, computed
+    // straight from the catalogs without building a CarDesign.
+    static DesignMetrics evaluate(const DesignParameters& params);
+    // Speed and fuel models applied to summed part attributes.
+    static DesignMetrics evaluate(const PartAttributes& totals);
+    // The speed model evaluate() uses, for callers summing drag and mass in float.
+    template <typename T>
+    static constexpr T speedModel(T drag, T mass) { return T(15000) / (drag + T(0.05) * mass); }
+    std::pmr::memory_resource* getMemoryResource() const { return aeroEfficiencies.get_allocator().resource(); }
 private:
     PartManager<FrontWing> frontWing;
     PartManager<RearWing> rearWing;
     PartManager<Diffuser> diffuser;
     PartManager<Sidepods> sidepods;
-    std::map<PartType, double> aeroEfficiencies;
+    std::pmr::map<PartType, double> aeroEfficiencies;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "CompactDesign.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COMPACTDESIGN_SSE2 1
+#endif
+
+namespace {
+
+const size_t BLOCK_ROWS = 1024;  // 20 KB of columns per block
+
+}
+
+PackedDesign CompactDesign::encode(const DesignParameters& params) {
+    PackedDesign code = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (params.parts[i] < 0 || static_cast<uint32_t>(params.parts[i]) > PART_MASK) {
+            throw std::invalid_argument("Part index does not fit the compact encoding");
+        }
+        code |= static_cast<PackedDesign>(params.parts[i]) << (i * PART_BITS);
+        double aero = std::clamp(params.aero[i], AERO_MIN, AERO_MAX);
+        auto level = static_cast<PackedDesign>(std::lround((aero - AERO_MIN) / AERO_STEP));
+        code |= level << (AERO_SHIFT + i * AERO_BITS);
+    }
+    return code;
+}
+
+DesignParameters CompactDesign::decode(PackedDesign code) {
+    DesignParameters params;
+    for (int i = 0; i < 4; ++i) {
+        params.parts[i] = static_cast<int>((code >> (i * PART_BITS)) & PART_MASK);
+        params.aero[i] = AERO_MIN + static_cast<double>((code >> (AERO_SHIFT + i * AERO_BITS)) & AERO_LEVELS) * AERO_STEP;
+    }
+    return params;
+}
+
+void CompactDesign::decodeColumns(const PackedDesign* codes, size_t count, uint8_t* const parts[4], float* const aero[4]) {
+    for (size_t row = 0; row < count; ++row) {
+        for (int i = 0; i < 4; ++i) parts[i][row] = static_cast<uint8_t>((codes[row] >> (i * PART_BITS)) & PART_MASK);
+    }
+
+    size_t row = 0;
+#ifdef COMPACTDESIGN_SSE2
+    const __m128i levelMask = _mm_set1_epi64x(AERO_LEVELS);
+    const __m128 step = _mm_set1_ps(static_cast<float>(AERO_STEP));
+    const __m128 minimum = _mm_set1_ps(static_cast<float>(AERO_MIN));
+    for (; row + 4 <= count; row += 4) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + row));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + row + 2));
+        for (int i = 0; i < 4; ++i) {
+            __m128i shift = _mm_cvtsi32_si128(AERO_SHIFT + i * AERO_BITS);
+            __m128i a = _mm_and_si128(_mm_srl_epi64(low, shift), levelMask);
+            __m128i b = _mm_and_si128(_mm_srl_epi64(high, shift), levelMask);
+            // Each field sits in the low 32 bits of its 64-bit lane; gather the four.
+            __m128i levels = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)),
+                                                _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm_storeu_ps(aero[i] + row, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(levels), step), minimum));
+        }
+    }
+#endif
+    for (; row < count; ++row) {
+        for (int i = 0; i < 4; ++i) {
+            auto level = static_cast<float>((codes[row] >> (AERO_SHIFT + i * AERO_BITS)) & AERO_LEVELS);
+            aero[i][row] = level * static_cast<float>(AERO_STEP) + static_cast<float>(AERO_MIN);
+        }
+    }
+}
+
+size_t CompactLibrary::deduplicate() {
+    size_t before = codes.size();
+    std::sort(codes.begin(), codes.end());
+    codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+    return before - codes.size();
+}
+
+std::vector<size_t> CompactLibrary::fastest(size_t topK) const {
+    // Drag and mass per part slot; NaN marks indices missing from a catalog,
+    // which makes the speed NaN and keeps the design out of the ranking.
+    const size_t slots = CompactDesign::PART_MASK + 1;
+    float drag[4][CompactDesign::PART_MASK + 1];
+    float mass[4][CompactDesign::PART_MASK + 1];
+    PartAttributes (*const catalogs[4])(int) = {FrontWing::getDesignAttributes, RearWing::getDesignAttributes,
+                                                Diffuser::getDesignAttributes, Sidepods::getDesignAttributes};
+    const int counts[4] = {FrontWing::getDesignCount(), RearWing::getDesignCount(), Diffuser::getDesignCount(),
+                           Sidepods::getDesignCount()};
+    for (int i = 0; i < 4; ++i) {
+        for (size_t slot = 0; slot < slots; ++slot) {
+            bool known = static_cast<int>(slot) < counts[i];
+            PartAttributes attributes = known ? catalogs[i](static_cast<int>(slot)) : PartAttributes{};
+            drag[i][slot] = known ? static_cast<float>(attributes.drag) : NAN;
+            mass[i][slot] = known ? static_cast<float>(attributes.mass) : NAN;
+        }
+    }
+
+    using Entry = std::pair<float, size_t>;
+    std::vector<Entry> heap;  // min-heap on speed
+    auto slower = [](const Entry& a, const Entry& b) { return a.first > b.first; };
+
+    uint8_t partColumns[4][BLOCK_ROWS];
+    float aeroColumns[4][BLOCK_ROWS];
+    uint8_t* const parts[4] = {partColumns[0], partColumns[1], partColumns[2], partColumns[3]};
+    float* const aero[4] = {aeroColumns[0], aeroColumns[1], aeroColumns[2], aeroColumns[3]};
+    float speeds[BLOCK_ROWS];
+    for (size_t begin = 0; begin < codes.size(); begin += BLOCK_ROWS) {
+        size_t count = std::min(BLOCK_ROWS, codes.size() - begin);
+        CompactDesign::decodeColumns(codes.data() + begin, count, parts, aero);
+        for (size_t row = 0; row < count; ++row) {
+            float totalDrag = 0.0f, totalMass = 0.0f;
+            for (int i = 0; i < 4; ++i) {
+                totalDrag += drag[i][parts[i][row]] * aero[i][row];
+                totalMass += mass[i][parts[i][row]] * aero[i][row];
+            }
+            speeds[row] = CarDesign::speedModel(totalDrag, totalMass);
+        }
+        for (size_t row = 0; row < count; ++row) {
+            if (!(speeds[row] > 0.0f) || topK == 0) continue;
+            Entry entry{speeds[row], begin + row};
+            if (heap.size() < topK) {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), slower);
+            } else if (entry.first > heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end(), slower);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), slower);
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), slower);
+    std::vector<size_t> result;
+    result.reserve(heap.size());
+    for (const auto& entry : heap) result.push_back(entry.second);
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef COMPACTDESIGN_H
+#define COMPACTDESIGN_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using PackedDesign = uint64_t;
+
+// Lossy 8-byte encoding of DesignParameters for holding very large numbers
+// of designs in memory. The text .f1design form stays the lossless one.
+//
+// Bits 0-11 hold the four part indices, 3 bits each (part i at bit 3i).
+// Bits 12-63 hold the four aero factors, 13 bits each (aero i at bit
+// 12 + 13i), quantized uniformly over [0.5, 1.5]. Aero factors are clamped to
+// that range first, as adjustAeroEfficiency and evaluate do, so a decoded
+// factor is within MAX_AERO_ERROR of the clamped original and encoding an
+// already decoded design is exact.
+class CompactDesign {
+public:
+    static constexpr int PART_BITS = 3;
+    static constexpr int AERO_BITS = 13;
+    static constexpr int AERO_SHIFT = 4 * PART_BITS;
+    static constexpr uint32_t PART_MASK = (1u << PART_BITS) - 1;
+    static constexpr uint32_t AERO_LEVELS = (1u << AERO_BITS) - 1;
+    static constexpr double AERO_MIN = 0.5;
+    static constexpr double AERO_MAX = 1.5;
+    static constexpr double AERO_STEP = (AERO_MAX - AERO_MIN) / AERO_LEVELS;
+    static constexpr double MAX_AERO_ERROR = AERO_STEP / 2;
+
+    // Throws std::invalid_argument for a part index that does not fit in PART_BITS.
+    static PackedDesign encode(const DesignParameters& params);
+    static DesignParameters decode(PackedDesign code);
+
+    // Unpacks count codes into columns: parts[i][row] and aero[i][row].
+    // Uses SSE2 four codes at a time where available.
+    static void decodeColumns(const PackedDesign* codes, size_t count, uint8_t* const parts[4], float* const aero[4]);
+};
+
+// Library of packed designs: 8 bytes per design, scanned in cache-sized
+// blocks that are decoded into columns and evaluated from per-part tables.
+class CompactLibrary {
+public:
+    void reserve(size_t count) { codes.reserve(count); }
+    void add(const DesignParameters& params) { codes.push_back(CompactDesign::encode(params)); }
+    size_t size() const { return codes.size(); }
+    size_t memoryUsage() const { return codes.capacity() * sizeof(PackedDesign); }
+    PackedDesign at(size_t index) const { return codes.at(index); }
+
+    // Sorts the codes and drops designs that encode identically, i.e. equal
+    // parts and aero factors within one quantization step. Returns how many
+    // were removed.
+    size_t deduplicate();
+    // Indices of the topK fastest designs, fastest first.
+    std::vector<size_t> fastest(size_t topK) const;
+
+private:
+    std::vector<PackedDesign> codes;
+};
+
+#endif
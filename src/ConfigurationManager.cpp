@@ -1,7 +1,15 @@
 #include "ConfigurationManager.h"
+#include "DesignArena.h"
+#include "DesignVersionHistory.h"
+#include "LibraryIndex.h"
+#include "TraceRecorder.h"
 #include <filesystem>
 #include <algorithm>
+#include <cstring>
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <dirent.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -20,6 +28,7 @@ void ConfigurationManager::ensureDesignsDirectory() {
 }
 
 std::vector<std::string> ConfigurationManager::getDesignFiles() {
+    TRACE_ZONE("ConfigurationManager::getDesignFiles");
     ensureDesignsDirectory();
     std::vector<std::string> files;
     try {
@@ -35,9 +44,46 @@ std::vector<std::string> ConfigurationManager::getDesignFiles() {
     return files;
 }
 
+std::pmr::vector<std::pmr::string> ConfigurationManager::getDesignFiles(std::pmr::memory_resource* resource) {
+    TRACE_ZONE("ConfigurationManager::getDesignFiles");
+    ensureDesignsDirectory();
+    std::pmr::vector<std::pmr::string> files(resource);
+#ifndef _WIN32
+    // Names go straight from the directory entry into resource, with no
+    // fs::path or std::string on the way.
+    if (DIR* directory = ::opendir("designs")) {
+        const size_t extension = std::strlen(".f1design");
+        while (const dirent* entry = ::readdir(directory)) {
+            size_t length = std::strlen(entry->d_name);
+            if (length > extension && std::strcmp(entry->d_name + length - extension, ".f1design") == 0) {
+                files.emplace_back(entry->d_name, length - extension);
+            }
+        }
+        ::closedir(directory);
+    }
+#else
+    try {
+        for (const auto& entry : fs::directory_iterator("designs")) {
+            if (entry.path().extension() == ".f1design") {
+                files.emplace_back(entry.path().stem().string());
+            }
+        }
+    } catch (const fs::filesystem_error& e) {
+        // Return empty list instead of throwing
+    }
+#endif
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
 void ConfigurationManager::processDesigns(DesignProcessor processor) {
-    CarDesign design;
-    for (const auto& file : getDesignFiles()) {
+    DesignArena arena;
+    processDesigns(processor, arena.resource());
+}
+
+void ConfigurationManager::processDesigns(DesignProcessor processor, std::pmr::memory_resource* resource) {
+    CarDesign design(resource);
+    for (const auto& file : getDesignFiles(resource)) {
         try {
             design.loadFromFile(file);
             processor(design);
@@ -48,6 +94,7 @@ void ConfigurationManager::processDesigns(DesignProcessor processor) {
 }
 
 int ConfigurationManager::countDesignFiles(const std::string& path) {
+    TRACE_ZONE("ConfigurationManager::countDesignFiles");
     ensureDesignsDirectory();
     int count = 0;
     try {
@@ -65,20 +112,96 @@ int ConfigurationManager::countDesignFiles(const std::string& path) {
     return count;
 }
 
+uint64_t ConfigurationManager::designFilesStamp() {
+    TRACE_ZONE("ConfigurationManager::designFilesStamp");
+    // Entries are summed, so the listing order does not matter.
+    uint64_t sum = 0, count = 0;
+    std::error_code error;
+    for (fs::directory_iterator it("designs", error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != ".f1design") continue;
+        uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a
+        for (auto c : it->path().filename().native()) hash = (hash ^ static_cast<uint64_t>(c)) * 0x100000001B3ull;
+        // Any write moves the modification time, so the size adds nothing but a second stat.
+        std::error_code statError;
+        auto modified = it->last_write_time(statError);
+        if (!statError) hash = (hash ^ static_cast<uint64_t>(modified.time_since_epoch().count())) * 0x9E3779B97F4A7C15ull;
+        sum += hash ^ (hash >> 31);
+        ++count;
+    }
+    if (error) return 0;
+    uint64_t stamp = (sum ^ count) * 0x94D049BB133111EBull;
+    return stamp != 0 ? stamp : 1;
+}
+
+int64_t ConfigurationManager::designsDirectoryTime() {
+    std::error_code error;
+    auto time = fs::last_write_time("designs", error);
+    return error ? INT64_MIN : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
 bool ConfigurationManager::designExists(const std::string& name) {
     ensureDesignsDirectory();
     return fs::exists("designs/" + name + ".f1design");
 }
 
 void ConfigurationManager::backupDesign(const std::string& filename) {
+    // The on-disk version is appended to the design's history as a delta
+    // (a no-op when it is already the latest recorded version).
+    recordVersion(filename);
+}
+
+void ConfigurationManager::recordVersion(const std::string& filename) {
     ensureDesignsDirectory();
     if (designExists(filename)) {
         try {
-            fs::copy_file("designs/" + filename + ".f1design",
-                          "designs/" + filename + ".bak",
-                          fs::copy_options::overwrite_existing);
-        } catch (const fs::filesystem_error& e) {
+            CarDesign saved;
+            saved.loadFromFile(filename);
+            DesignVersionHistory(filename).append(saved.getParameters());
+        } catch (const std::exception& e) {
             // Log error but don't throw
         }
     }
+}
+
+void ConfigurationManager::saveDesign(const CarDesign& design, const std::string& filename) {
+    writeDesign(design, filename);
+    try {
+        getLibraryIndex().upsert(filename, design.getParameters());
+    } catch (const std::exception& e) {
+        getLibraryIndex().invalidate();
+    }
+}
+
+void ConfigurationManager::deleteDesign(const std::string& filename) {
+    ensureDesignsDirectory();
+    try {
+        fs::remove("designs/" + filename + ".f1design");
+    } catch (const fs::filesystem_error& e) {
+        throw std::runtime_error("Failed to delete design");
+    }
+    try {
+        getLibraryIndex().remove(filename);
+    } catch (const std::exception& e) {
+        getLibraryIndex().invalidate();
+    }
+}
+
+void ConfigurationManager::writeDesign(const CarDesign& design, const std::string& filename) {
+    backupDesign(filename);
+    design.saveToFile(filename);
+    recordVersion(filename);
+}
+
+LibraryIndex& ConfigurationManager::getLibraryIndex() {
+    static LibraryIndex& index = []() -> LibraryIndex& {
+        static LibraryIndex opened;
+        ensureDesignsDirectory();
+        try {
+            opened.open();
+        } catch (const std::exception& e) {
+            // Serve the in-memory index; the file is rewritten on the next compaction
+        }
+        return opened;
+    }();
+    return index;
 }
\ No newline at end of file
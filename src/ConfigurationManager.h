@@ -2,19 +2,42 @@
 #define CONFIGURATIONMANAGER_H
 
 #include "CarDesign.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <memory_resource>
 
 using DesignProcessor = void (*)(const CarDesign&);
 
+class LibraryIndex;
+
 class ConfigurationManager {
 public:
     static std::vector<std::string> getDesignFiles();
+    // Batch variant: the list and every name in it come from resource.
+    static std::pmr::vector<std::pmr::string> getDesignFiles(std::pmr::memory_resource* resource);
     static void processDesigns(DesignProcessor processor);
+    // Batch variant: the file list and the working CarDesign come from resource.
+    static void processDesigns(DesignProcessor processor, std::pmr::memory_resource* resource);
     static int countDesignFiles(const std::string& path);
+    // Hash of the name and modification time of every .f1design file,
+    // for caches of the library to tell whether it changed. Other files in
+    // designs/ do not affect it. Costs a directory listing; 0 if the listing failed.
+    static uint64_t designFilesStamp();
+    // Modification time of the designs directory: a single stat that stays
+    // put while no file in it is created, renamed or removed.
+    static int64_t designsDirectoryTime();
     static bool designExists(const std::string& name);
     static void backupDesign(const std::string& filename);
+    static void recordVersion(const std::string& filename);
+    // Backs up, writes and records a design, keeping the library index current.
+    static void saveDesign(const CarDesign& design, const std::string& filename);
+    // saveDesign() without the index update, for batch savers that update the
+    // index themselves. Safe to call for different designs at once.
+    static void writeDesign(const CarDesign& design, const std::string& filename);
+    static void deleteDesign(const std::string& filename);
+    static LibraryIndex& getLibraryIndex();
 
     static void ensureDesignsDirectory(); // Added public static method declaration
 };
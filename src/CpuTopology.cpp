@@ -0,0 +1,108 @@
+#include "CpuTopology.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fs = std::filesystem;
+
+std::atomic<bool> CpuTopology::pinningEnabled{false};
+
+namespace {
+
+#ifdef __linux__
+// Parses a sysfs CPU list such as "0-3,8-11".
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> result;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+        } catch (const std::exception& e) {
+            // Skip malformed ranges
+        }
+    }
+    return result;
+}
+#endif
+
+}
+
+CpuTopology::CpuTopology() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool masked = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto usable = [&](int cpu) { return cpu >= 0 && cpu < CPU_SETSIZE && (!masked || CPU_ISSET(cpu, &allowed)); };
+    std::vector<std::pair<int, std::vector<int>>> found;
+    std::error_code error;
+    for (fs::directory_iterator it("/sys/devices/system/node", error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream file(it->path() / "cpulist");
+        std::string text;
+        if (!std::getline(file, text)) continue;
+        std::vector<int> cpusOnNode;
+        for (int cpu : parseCpuList(text)) {
+            if (usable(cpu)) cpusOnNode.push_back(cpu);
+        }
+        if (!cpusOnNode.empty()) found.emplace_back(std::stoi(name.substr(4)), std::move(cpusOnNode));
+    }
+    std::sort(found.begin(), found.end());
+    for (auto& node : found) nodes.push_back(std::move(node.second));
+    if (nodes.empty()) {
+        std::vector<int> all;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (masked ? CPU_ISSET(cpu, &allowed) : cpu < static_cast<int>(std::thread::hardware_concurrency())) all.push_back(cpu);
+        }
+        if (!all.empty()) nodes.push_back(std::move(all));
+    }
+#endif
+    if (nodes.empty()) {
+        std::vector<int> all(std::max(1u, std::thread::hardware_concurrency()));
+        for (size_t cpu = 0; cpu < all.size(); ++cpu) all[cpu] = static_cast<int>(cpu);
+        nodes.push_back(std::move(all));
+    }
+    for (const auto& node : nodes) cpus += node.size();
+}
+
+const CpuTopology& CpuTopology::current() {
+    static const CpuTopology topology;
+    return topology;
+}
+
+int CpuTopology::cpuForWorker(size_t index) const {
+    const std::vector<int>& node = nodes[nodeOfWorker(index)];
+    return node[(index / nodes.size()) % node.size()];
+}
+
+bool CpuTopology::pinCurrentThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void CpuTopology::pinWorker(size_t index) {
+    if (pinning()) pinCurrentThread(current().cpuForWorker(index));
+}
@@ -0,0 +1,45 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// The CPUs this process may run on, grouped by NUMA node. On Linux nodes
+// come from /sys/devices/system/node, limited to the process affinity mask;
+// elsewhere, or without that information, every CPU is on node 0.
+//
+// With pinning on (--pin-threads), the workers of the shared compute pool,
+// which also runs the bulk loops, pin themselves with pinWorker(), spread
+// round-robin over the nodes so each node's memory controller serves its
+// share of the workers. Buffers a pinned worker allocates and fills itself are placed on
+// its node by the kernel's first-touch policy. Pinning is a no-op where
+// thread affinity is unsupported.
+class CpuTopology {
+public:
+    static const CpuTopology& current();
+
+    size_t cpuCount() const { return cpus; }
+    size_t nodeCount() const { return nodes.size(); }
+    const std::vector<int>& nodeCpus(size_t node) const { return nodes[node]; }
+    // Worker index goes to node index % nodeCount(), then to the next CPU of that node.
+    size_t nodeOfWorker(size_t index) const { return index % nodes.size(); }
+    int cpuForWorker(size_t index) const;
+
+    // Returns false if the thread could not be pinned.
+    static bool pinCurrentThread(int cpu);
+    static void setPinning(bool enabled) { pinningEnabled.store(enabled, std::memory_order_relaxed); }
+    static bool pinning() { return pinningEnabled.load(std::memory_order_relaxed); }
+    // Pins the calling thread as worker index when pinning is on. Worker 0 is
+    // left to the main thread, so pool workers pin from index 1.
+    static void pinWorker(size_t index);
+
+private:
+    CpuTopology();
+
+    std::vector<std::vector<int>> nodes;
+    size_t cpus{0};
+    static std::atomic<bool> pinningEnabled;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "DesignArena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+thread_local size_t threadHeapAllocations = 0;
+thread_local size_t threadHeapBytes = 0;
+
+}
+
+// Replacement global allocation functions, counting calls per thread. The
+// array and nothrow forms forward to these. std::pmr::new_delete_resource()
+// uses the aligned ones, so arena overflow is counted too.
+void* operator new(std::size_t size) {
+    ++threadHeapAllocations;
+    threadHeapBytes += size;
+    while (true) {
+        if (void* p = std::malloc(size != 0 ? size : 1)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    ++threadHeapAllocations;
+    threadHeapBytes += size;
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    while (true) {
+#ifdef _WIN32
+        if (void* p = _aligned_malloc(size != 0 ? size : 1, align)) return p;
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, align, size != 0 ? size : 1) == 0) return p;
+#endif
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(p, alignment);
+}
+
+HeapUsage HeapUsage::thisThread() {
+    return {threadHeapAllocations, threadHeapBytes};
+}
+
+CountingResource::CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+void CountingResource::resetCounts() {
+    allocations.store(0, std::memory_order_relaxed);
+    bytes.store(0, std::memory_order_relaxed);
+}
+
+void* CountingResource::do_allocate(size_t size, size_t alignment) {
+    void* p = upstream->allocate(size, alignment);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    inUse.fetch_add(size, std::memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t size, size_t alignment) {
+    upstream->deallocate(p, size, alignment);
+    inUse.fetch_sub(size, std::memory_order_relaxed);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+DesignArena::DesignArena(size_t initialBytes) : arenaCounter(nullptr) {
+    rebuild(initialBytes);
+}
+
+void DesignArena::rebuild(size_t size) {
+    arena.reset();
+    buffer = std::make_unique<std::byte[]>(size);
+    bufferSize = size;
+    arena.emplace(buffer.get(), bufferSize, &heapCounter);
+    arenaCounter.setUpstream(&*arena);
+}
+
+void DesignArena::release() {
+    // Bytes requested during this batch, including what spilled to the heap.
+    size_t used = arenaCounter.bytesAllocated() - batchBytes;
+    if (heapCounter.bytesInUse() > 0) {
+        rebuild(std::max(used + used / 2, bufferSize * 2));
+    } else {
+        arena->release();
+    }
+    batchBytes = arenaCounter.bytesAllocated();
+}
+
+AllocationStats DesignArena::stats() const {
+    return {arenaCounter.allocationCount(), arenaCounter.bytesAllocated(),
+            heapCounter.allocationCount(), heapCounter.bytesAllocated(), heapAllocations, heapBytes};
+}
+
+void DesignArena::resetStats() {
+    arenaCounter.resetCounts();
+    heapCounter.resetCounts();
+    batchBytes = 0;
+    heapAllocations = 0;
+    heapBytes = 0;
+}
+
+DesignArena::HeapWatch::~HeapWatch() {
+    HeapUsage now = HeapUsage::thisThread();
+    arena.heapAllocations += now.allocations - start.allocations;
+    arena.heapBytes += now.bytes - start.bytes;
+}
+
+DesignArenaPool::Lease::~Lease() {
+    if (!arena) return;
+    arena->release();
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->idle.push_back(std::move(arena));
+}
+
+DesignArenaPool::Lease DesignArenaPool::acquire() {
+    std::unique_ptr<DesignArena> arena;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            arena = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+    if (!arena) arena = std::make_unique<DesignArena>();
+    return Lease(*this, std::move(arena));
+}
+
+AllocationStats DesignArenaPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    AllocationStats total;
+    for (const auto& arena : idle) {
+        AllocationStats one = arena->stats();
+        total.arenaAllocations += one.arenaAllocations;
+        total.arenaBytes += one.arenaBytes;
+        total.overflowAllocations += one.overflowAllocations;
+        total.overflowBytes += one.overflowBytes;
+        total.heapAllocations += one.heapAllocations;
+        total.heapBytes += one.heapBytes;
+    }
+    return total;
+}
@@ -0,0 +1,122 @@
+#ifndef DESIGNARENA_H
+#define DESIGNARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Forwards to an upstream resource and counts what passes through.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    size_t allocationCount() const { return allocations.load(std::memory_order_relaxed); }
+    size_t bytesAllocated() const { return bytes.load(std::memory_order_relaxed); }
+    size_t bytesInUse() const { return inUse.load(std::memory_order_relaxed); }
+    void resetCounts();
+    void setUpstream(std::pmr::memory_resource* resource) { upstream = resource; }
+private:
+    void* do_allocate(size_t size, size_t alignment) override;
+    void do_deallocate(void* p, size_t size, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream;
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> inUse{0};
+};
+
+// Global operator new calls made by the calling thread since it started,
+// counted by the replacement operator new in DesignArena.cpp. Unlike the
+// arena's own counters this sees every allocation, strings and paths included.
+struct HeapUsage {
+    size_t allocations{0};
+    size_t bytes{0};
+    static HeapUsage thisThread();
+};
+
+struct AllocationStats {
+    size_t arenaAllocations{0};     // requests served by the arena
+    size_t arenaBytes{0};
+    size_t overflowAllocations{0};  // arena requests passed to the heap because its buffer was full
+    size_t overflowBytes{0};
+    size_t heapAllocations{0};      // global operator new calls made under a HeapWatch
+    size_t heapBytes{0};
+};
+
+// Monotonic arena for batch work on CarDesign objects. Everything allocated
+// from resource() is released in one shot by release(). When a batch overflows
+// the arena's buffer, the next release() grows the buffer to the observed peak,
+// so repeated batches of similar size stop reaching the global heap.
+// Not thread-safe; use one arena per worker.
+class DesignArena {
+public:
+    // Adds the global heap allocations the calling thread makes while it is
+    // alive to the arena's stats(), whether or not they went through the arena.
+    class HeapWatch {
+    public:
+        explicit HeapWatch(DesignArena& arena) : arena(arena), start(HeapUsage::thisThread()) {}
+        ~HeapWatch();
+        HeapWatch(const HeapWatch&) = delete;
+        HeapWatch& operator=(const HeapWatch&) = delete;
+
+    private:
+        DesignArena& arena;
+        HeapUsage start;
+    };
+
+    explicit DesignArena(size_t initialBytes = 64 * 1024);
+    DesignArena(const DesignArena&) = delete;
+    DesignArena& operator=(const DesignArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arenaCounter; }
+    void release();
+    AllocationStats stats() const;
+    void resetStats();
+    size_t capacity() const { return bufferSize; }
+
+private:
+    void rebuild(size_t size);
+
+    CountingResource heapCounter;
+    std::unique_ptr<std::byte[]> buffer;
+    size_t bufferSize{0};
+    size_t batchBytes{0};
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+    CountingResource arenaCounter;
+    size_t heapAllocations{0};
+    size_t heapBytes{0};
+};
+
+// Arenas for batches run on a thread pool. acquire() hands out an arena no
+// other batch is using, creating one only when all are busy, so there is at
+// most one per worker; the lease releases it and gives it back.
+class DesignArenaPool {
+public:
+    class Lease {
+    public:
+        Lease(DesignArenaPool& pool, std::unique_ptr<DesignArena> arena) : pool(&pool), arena(std::move(arena)) {}
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+        DesignArena& operator*() { return *arena; }
+        DesignArena* operator->() { return arena.get(); }
+
+    private:
+        DesignArenaPool* pool;
+        std::unique_ptr<DesignArena> arena;
+    };
+
+    Lease acquire();
+    // Summed over every arena the pool created. Call once no lease is out.
+    AllocationStats stats() const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<DesignArena>> idle;
+};
+
+#endif
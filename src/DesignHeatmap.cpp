@@ -0,0 +1,90 @@
+#include "DesignHeatmap.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+PartAttributes partAttributes(int part, int designIndex) {
+    switch (part) {
+    case 0: return FrontWing::getDesignAttributes(designIndex);
+    case 1: return RearWing::getDesignAttributes(designIndex);
+    case 2: return Diffuser::getDesignAttributes(designIndex);
+    default: return Sidepods::getDesignAttributes(designIndex);
+    }
+}
+
+}
+
+DesignHeatmap::DesignHeatmap(const HeatmapSpec& spec) : heatmapSpec(spec) {
+    if (spec.xAxis < 0 || spec.xAxis > 3 || spec.yAxis < 0 || spec.yAxis > 3 || spec.xAxis == spec.yAxis) {
+        throw std::invalid_argument("Heatmap axes must be two different aero factors");
+    }
+    if (spec.width <= 0 || spec.height <= 0) throw std::invalid_argument("Heatmap size must be positive");
+    for (int part = 0; part < 4; ++part) {
+        PartAttributes attributes = partAttributes(part, spec.base.parts[part]);
+        if (part == spec.xAxis) {
+            xPart = attributes;
+        } else if (part == spec.yAxis) {
+            yPart = attributes;
+        } else {
+            fixed = fixed + attributes * std::clamp(spec.base.aero[part], AXIS_MIN, AXIS_MAX);
+        }
+    }
+}
+
+double DesignHeatmap::xValue(int x) const {
+    return AXIS_MIN + (x + 0.5) / heatmapSpec.width * (AXIS_MAX - AXIS_MIN);
+}
+
+double DesignHeatmap::yValue(int y) const {
+    return AXIS_MAX - (y + 0.5) / heatmapSpec.height * (AXIS_MAX - AXIS_MIN);
+}
+
+float DesignHeatmap::evaluate(int x, int y) const {
+    DesignMetrics metrics = CarDesign::evaluate(fixed + xPart * xValue(x) + yPart * yValue(y));
+    switch (heatmapSpec.metric) {
+    case HeatmapMetric::FUEL: return static_cast<float>(metrics.fuelConsumption);
+    case HeatmapMetric::COST: return static_cast<float>(metrics.attributes.cost);
+    default: return static_cast<float>(metrics.speed);
+    }
+}
+
+void DesignHeatmap::refine(int step, int rowBegin, int rowEnd, float* values) const {
+    const int width = heatmapSpec.width;
+    for (int y = rowBegin; y < rowEnd; y += step) {
+        int blockRows = std::min(step, rowEnd - y);
+        // A coarser pass already sampled every other column on even sample rows.
+        bool sampledRow = step < COARSEST_STEP && y % (2 * step) == 0;
+        for (int x = sampledRow ? step : 0; x < width; x += sampledRow ? 2 * step : step) {
+            float value = evaluate(x, y);
+            int blockColumns = std::min(step, width - x);
+            for (int row = 0; row < blockRows; ++row) {
+                std::fill_n(values + static_cast<size_t>(y - rowBegin + row) * width + x, blockColumns, value);
+            }
+        }
+    }
+}
+
+void DesignHeatmap::colorize(const float* values, size_t count, uint32_t* rgba) {
+    if (count == 0) return;
+    auto [low, high] = std::minmax_element(values, values + count);
+    float range = *high - *low > 0.0f ? *high - *low : 1.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float t = (values[i] - *low) / range;
+        float red = std::clamp(2.0f * t - 1.0f, 0.0f, 1.0f);
+        float green = 1.0f - std::abs(2.0f * t - 1.0f);
+        float blue = std::clamp(1.0f - 2.0f * t, 0.0f, 1.0f);
+        // Bytes R, G, B, A in memory on little-endian hosts.
+        rgba[i] = static_cast<uint32_t>(red * 255.0f) | static_cast<uint32_t>(green * 255.0f) << 8 |
+                  static_cast<uint32_t>(blue * 255.0f) << 16 | 0xFF000000u;
+    }
+}
+
+const char* DesignHeatmap::metricName(HeatmapMetric metric) {
+    switch (metric) {
+    case HeatmapMetric::FUEL: return "Fuel (L/100km)";
+    case HeatmapMetric::COST: return "Cost ($)";
+    default: return "Speed (km/h)";
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef DESIGNHEATMAP_H
+#define DESIGNHEATMAP_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+
+enum class HeatmapMetric { SPEED, FUEL, COST };
+
+struct HeatmapSpec {
+    DesignParameters base;        // parts and the aero factors not on an axis
+    int xAxis{0};                 // aero factor (index into base.aero) swept left to right
+    int yAxis{1};                 // aero factor swept bottom to top
+    HeatmapMetric metric{HeatmapMetric::SPEED};
+    int width{320};
+    int height{320};
+
+    bool operator==(const HeatmapSpec& other) const = default;
+};
+
+// One metric over two aero factors, each swept across [0.5, 1.5] with the
+// rest of the design fixed. Pixel (x, y) shows the value at its centre.
+//
+// Images are computed progressively: the COARSEST_STEP pass samples every
+// 16th pixel in both directions and fills 16x16 blocks; each following pass
+// halves the step and samples only the pixels no coarser pass did, until
+// step 1 where every pixel holds its own exact value. Passes work on
+// independent bands of rows so they can run on several threads.
+class DesignHeatmap {
+public:
+    static constexpr int COARSEST_STEP = 16;
+    static constexpr double AXIS_MIN = 0.5;
+    static constexpr double AXIS_MAX = 1.5;
+
+    explicit DesignHeatmap(const HeatmapSpec& spec);
+
+    const HeatmapSpec& spec() const { return heatmapSpec; }
+    double xValue(int x) const;
+    double yValue(int y) const;
+    float evaluate(int x, int y) const;
+    // Runs the pass for step over rows [rowBegin, rowEnd). values holds
+    // those rows, width floats each; rowBegin must be a multiple of
+    // COARSEST_STEP so blocks never cross bands.
+    void refine(int step, int rowBegin, int rowEnd, float* values) const;
+
+    // Maps values to RGBA8 from blue (lowest) through green to red (highest).
+    static void colorize(const float* values, size_t count, uint32_t* rgba);
+    static const char* metricName(HeatmapMetric metric);
+
+private:
+    HeatmapSpec heatmapSpec;
+    PartAttributes fixed;  // parts off the axes, aero applied
+    PartAttributes xPart;  // axis parts at aero 1.0
+    PartAttributes yPart;
+};
+
+#endif
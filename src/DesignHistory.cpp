@@ -0,0 +1,145 @@
+#include "DesignHistory.h"
+#include <stdexcept>
+
+DesignHistory::DesignHistory(const DesignParameters& initial) {
+    reset(initial);
+}
+
+void DesignHistory::reset(const DesignParameters& initial) {
+    nodes.clear();
+    deltas.clear();
+    keyframes.clear();
+    currentState = initial;
+    for (int field = 0; field < 8; ++field) {
+        setField(currentState, field, static_cast<float>(fieldValue(initial, field)));
+    }
+    nodes.push_back({NO_NODE, NO_NODE, 0, 0, 0, 0});
+    keyframes.push_back({0, 0, currentState});
+    currentIndex = 0;
+}
+
+double DesignHistory::fieldValue(const DesignParameters& state, int field) {
+    return field < 4 ? state.parts[field] : state.aero[field - 4];
+}
+
+void DesignHistory::setField(DesignParameters& state, int field, double value) {
+    if (field < 4) state.parts[field] = static_cast<int>(value);
+    else state.aero[field - 4] = value;
+}
+
+bool DesignHistory::record(const DesignParameters& state, bool coalesce) {
+    Delta changed[8];
+    uint16_t changedCount = 0;
+    for (int field = 0; field < 8; ++field) {
+        float value = static_cast<float>(fieldValue(state, field));
+        if (value != fieldValue(currentState, field)) {
+            changed[changedCount++] = {static_cast<uint8_t>(field), value};
+        }
+    }
+    if (changedCount == 0) return false;
+
+    Node& node = nodes[currentIndex];
+    if (coalesce && currentIndex != 0 && node.lastChild == NO_NODE && node.deltaCount == 1 &&
+        changedCount == 1 && deltas[node.firstDelta].field == changed[0].field) {
+        deltas[node.firstDelta].value = changed[0].value;
+        setField(currentState, changed[0].field, changed[0].value);
+        Keyframe& keyframe = keyframes[node.keyframe];
+        if (keyframe.node == currentIndex) keyframe.state = currentState;
+        return true;
+    }
+
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    Node next{static_cast<uint32_t>(currentIndex), NO_NODE, static_cast<uint32_t>(deltas.size()),
+              node.keyframe, changedCount, static_cast<uint16_t>(node.sinceKeyframe + 1)};
+    for (uint16_t i = 0; i < changedCount; ++i) {
+        deltas.push_back(changed[i]);
+        setField(currentState, changed[i].field, changed[i].value);
+    }
+    if (next.sinceKeyframe >= KEYFRAME_INTERVAL) {
+        uint32_t keyframeDepth = keyframes[node.keyframe].depth + next.sinceKeyframe;
+        next.keyframe = static_cast<uint32_t>(keyframes.size());
+        next.sinceKeyframe = 0;
+        keyframes.push_back({index, keyframeDepth, currentState});
+    }
+    nodes[currentIndex].lastChild = index;
+    nodes.push_back(next);
+    currentIndex = index;
+    return true;
+}
+
+bool DesignHistory::canUndo() const {
+    return currentIndex != 0;
+}
+
+bool DesignHistory::canRedo() const {
+    return nodes[currentIndex].lastChild != NO_NODE;
+}
+
+const DesignParameters& DesignHistory::undo() {
+    if (!canUndo()) return currentState;
+    size_t parent = nodes[currentIndex].parent;
+    nodes[parent].lastChild = static_cast<uint32_t>(currentIndex);
+    currentIndex = parent;
+    currentState = stateAt(currentIndex);
+    return currentState;
+}
+
+const DesignParameters& DesignHistory::redo() {
+    if (!canRedo()) return currentState;
+    currentIndex = nodes[currentIndex].lastChild;
+    currentState = stateAt(currentIndex);
+    return currentState;
+}
+
+const DesignParameters& DesignHistory::jumpTo(size_t node) {
+    if (node >= nodes.size()) throw std::out_of_range("History node out of range");
+    for (size_t n = node; n != 0; n = nodes[n].parent) {
+        nodes[nodes[n].parent].lastChild = static_cast<uint32_t>(n);
+    }
+    currentIndex = node;
+    currentState = stateAt(node);
+    return currentState;
+}
+
+size_t DesignHistory::depth(size_t node) const {
+    const Node& n = nodes.at(node);
+    return keyframes[n.keyframe].depth + n.sinceKeyframe;
+}
+
+DesignParameters DesignHistory::stateAt(size_t node) const {
+    const Keyframe& keyframe = keyframes[nodes.at(node).keyframe];
+    DesignParameters state = keyframe.state;
+    bool known[8] = {false, false, false, false, false, false, false, false};
+    // Walk towards the keyframe; the newest delta for each field wins.
+    for (size_t n = node; n != keyframe.node; n = nodes[n].parent) {
+        const Node& current = nodes[n];
+        for (uint32_t i = current.firstDelta; i < current.firstDelta + current.deltaCount; ++i) {
+            if (!known[deltas[i].field]) {
+                known[deltas[i].field] = true;
+                setField(state, deltas[i].field, deltas[i].value);
+            }
+        }
+    }
+    return state;
+}
+
+std::vector<size_t> DesignHistory::getBranchTips() const {
+    std::vector<size_t> tips;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].lastChild == NO_NODE) tips.push_back(i);
+    }
+    return tips;
+}
+
+std::vector<size_t> DesignHistory::currentBranch() const {
+    std::vector<size_t> branch(depth(currentIndex) + 1);
+    size_t n = currentIndex;
+    for (size_t i = branch.size(); i-- > 0; n = nodes[n].parent) branch[i] = n;
+    for (n = nodes[currentIndex].lastChild; n != NO_NODE; n = nodes[n].lastChild) branch.push_back(n);
+    return branch;
+}
+
+size_t DesignHistory::memoryUsage() const {
+    return nodes.capacity() * sizeof(Node) + deltas.capacity() * sizeof(Delta) +
+           keyframes.capacity() * sizeof(Keyframe);
+}
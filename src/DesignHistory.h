@@ -0,0 +1,79 @@
+#ifndef DESIGNHISTORY_H
+#define DESIGNHISTORY_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Branching undo/redo timeline for Design screen edits.
+//
+// Every edit is stored as a node holding only the fields it changed, linked to
+// its parent, so all variants share their common prefix. A full keyframe is
+// kept every KEYFRAME_INTERVAL levels of depth, which bounds the cost of
+// rebuilding any state (undo, redo or an arbitrary jump) to a constant walk of
+// at most KEYFRAME_INTERVAL nodes regardless of history length.
+// Aero factors are stored at float precision, matching the UI sliders.
+class DesignHistory {
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = 32;
+
+    explicit DesignHistory(const DesignParameters& initial = DesignParameters());
+    void reset(const DesignParameters& initial);
+
+    // Records a new state. With coalesce set, an edit that touches the same
+    // single field as the current leaf replaces it instead of appending, so a
+    // slider drag becomes one history step. Returns false if nothing changed.
+    bool record(const DesignParameters& state, bool coalesce = false);
+
+    bool canUndo() const;
+    bool canRedo() const;
+    const DesignParameters& undo();
+    const DesignParameters& redo();
+    // Moves to node and points redo along the path to it, so the current
+    // branch leads through the state jumped to.
+    const DesignParameters& jumpTo(size_t node);
+
+    const DesignParameters& current() const { return currentState; }
+    size_t currentNode() const { return currentIndex; }
+    size_t size() const { return nodes.size(); }
+    size_t depth(size_t node) const;
+    DesignParameters stateAt(size_t node) const;
+    // Leaves of the history tree, i.e. the latest state of every variant.
+    std::vector<size_t> getBranchTips() const;
+    // Nodes of the current branch by depth: the root, the current node's
+    // ancestors, the current node, then its redo chain down to the tip.
+    std::vector<size_t> currentBranch() const;
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint32_t NO_NODE = 0xFFFFFFFFu;
+    struct Delta {
+        uint8_t field;  // 0-3 part index, 4-7 aero factor
+        float value;
+    };
+    struct Node {
+        uint32_t parent;
+        uint32_t lastChild;   // redo target: most recently visited child, NO_NODE for a leaf
+        uint32_t firstDelta;
+        uint32_t keyframe;    // index into keyframes of the nearest keyframe ancestor
+        uint16_t deltaCount;
+        uint16_t sinceKeyframe;
+    };
+    struct Keyframe {
+        uint32_t node;
+        uint32_t depth;
+        DesignParameters state;
+    };
+
+    static double fieldValue(const DesignParameters& state, int field);
+    static void setField(DesignParameters& state, int field, double value);
+
+    std::vector<Node> nodes;
+    std::vector<Delta> deltas;
+    std::vector<Keyframe> keyframes;
+    size_t currentIndex{0};
+    DesignParameters currentState;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "DesignOptimizer.h"
+#include "LibraryStats.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+const int TOURNAMENT_SIZE = 3;
+const int ELITISM = 2;        // best designs copied unchanged into the next generation
+const size_t ELITE_SIZE = 32; // distinct best designs remembered per island
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+double uniform(uint64_t& state) {
+    return (splitmix64(state) >> 11) * 0x1.0p-53;
+}
+
+double gaussian(uint64_t& state) {
+    double u1 = ((splitmix64(state) >> 11) + 1) * 0x1.0p-53;
+    double u2 = (splitmix64(state) >> 11) * 0x1.0p-53;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+bool fitter(const OptimizerCandidate& a, const OptimizerCandidate& b) {
+    return a.fitness > b.fitness;
+}
+
+// Adds the candidates of a best-first population to a best-first list of
+// at most `limit` distinct designs.
+void mergeElite(std::vector<OptimizerCandidate>& elite, const std::vector<OptimizerCandidate>& population, size_t limit) {
+    if (limit == 0) return;
+    for (const auto& candidate : population) {
+        if (elite.size() == limit && !fitter(candidate, elite.back())) break;
+        bool known = std::any_of(elite.begin(), elite.end(),
+                                 [&](const OptimizerCandidate& kept) { return kept.params == candidate.params; });
+        if (known) continue;
+        elite.insert(std::upper_bound(elite.begin(), elite.end(), candidate, fitter), candidate);
+        if (elite.size() > limit) elite.pop_back();
+    }
+}
+
+}
+
+DesignOptimizer::DesignOptimizer(const OptimizerConfig& config, ThreadPoolExecutor& pool) : config(config), pool(pool) {
+    if (config.islands < 1 || config.population < 4 || config.generations < 0 || config.migrationInterval < 1 ||
+        config.migrants < 0 || config.migrants >= config.population) {
+        throw std::invalid_argument("Invalid optimizer configuration");
+    }
+    partCounts[0] = FrontWing::getDesignCount();
+    partCounts[1] = RearWing::getDesignCount();
+    partCounts[2] = Diffuser::getDesignCount();
+    partCounts[3] = Sidepods::getDesignCount();
+    auto speed = LibraryStats::metricBounds(StatMetric::SPEED);
+    auto fuel = LibraryStats::metricBounds(StatMetric::FUEL);
+    auto cost = LibraryStats::metricBounds(StatMetric::COST);
+    speedMin = speed.first;
+    speedRange = std::max(speed.second - speed.first, 1e-9);
+    fuelMin = fuel.first;
+    fuelRange = std::max(fuel.second - fuel.first, 1e-9);
+    costMin = cost.first;
+    costRange = std::max(cost.second - cost.first, 1e-9);
+
+    islands.resize(config.islands);
+    for (int i = 0; i < config.islands; ++i) {
+        Island& island = islands[i];
+        island.rng = config.seed ^ (static_cast<uint64_t>(i + 1) * 0xD1B54A32D192ED03ull);
+        for (int n = 0; n < config.population; ++n) island.population.push_back(makeCandidate(randomDesign(island.rng)));
+        std::stable_sort(island.population.begin(), island.population.end(), fitter);
+        mergeElite(island.elite, island.population, ELITE_SIZE);
+    }
+}
+
+double DesignOptimizer::fitness(const DesignMetrics& metrics) const {
+    return config.weights.speed * (metrics.speed - speedMin) / speedRange -
+           config.weights.fuel * (metrics.fuelConsumption - fuelMin) / fuelRange -
+           config.weights.cost * (metrics.attributes.cost - costMin) / costRange;
+}
+
+OptimizerCandidate DesignOptimizer::makeCandidate(const DesignParameters& params) const {
+    OptimizerCandidate candidate;
+    candidate.params = params;
+    candidate.metrics = CarDesign::evaluate(params);
+    candidate.fitness = fitness(candidate.metrics);
+    return candidate;
+}
+
+DesignParameters DesignOptimizer::randomDesign(uint64_t& rng) const {
+    DesignParameters params;
+    for (int i = 0; i < 4; ++i) {
+        params.parts[i] = static_cast<int>(splitmix64(rng) % static_cast<uint64_t>(partCounts[i]));
+        params.aero[i] = 0.5 + uniform(rng);
+    }
+    return params;
+}
+
+void DesignOptimizer::evolve(Island& island, int generations) const {
+    TRACE_ZONE("DesignOptimizer island");
+    const int size = config.population;
+    auto tournament = [&]() -> const OptimizerCandidate& {
+        // The population is sorted, so the lowest index drawn wins.
+        size_t winner = size;
+        for (int round = 0; round < TOURNAMENT_SIZE; ++round) {
+            winner = std::min(winner, static_cast<size_t>(splitmix64(island.rng) % static_cast<uint64_t>(size)));
+        }
+        return island.population[winner];
+    };
+
+    std::vector<OptimizerCandidate> next;
+    next.reserve(size);
+    for (int generation = 0; generation < generations; ++generation) {
+        next.assign(island.population.begin(), island.population.begin() + std::min(ELITISM, size));
+        while (static_cast<int>(next.size()) < size) {
+            const DesignParameters& a = tournament().params;
+            const DesignParameters& b = tournament().params;
+            DesignParameters child;
+            for (int i = 0; i < 4; ++i) {
+                child.parts[i] = (splitmix64(island.rng) & 1) ? a.parts[i] : b.parts[i];
+                child.aero[i] = (splitmix64(island.rng) & 1) ? a.aero[i] : b.aero[i];
+                if (uniform(island.rng) < config.mutationRate) {
+                    child.parts[i] = static_cast<int>(splitmix64(island.rng) % static_cast<uint64_t>(partCounts[i]));
+                }
+                if (uniform(island.rng) < config.mutationRate) {
+                    child.aero[i] = std::clamp(child.aero[i] + config.aeroSigma * gaussian(island.rng), 0.5, 1.5);
+                }
+            }
+            next.push_back(makeCandidate(child));
+        }
+        std::stable_sort(next.begin(), next.end(), fitter);
+        island.population.swap(next);
+        mergeElite(island.elite, island.population, ELITE_SIZE);
+
+        double sum = 0.0;
+        for (const auto& candidate : island.population) sum += candidate.fitness;
+        island.bestByGeneration.push_back(island.elite.front().fitness);
+        island.meanByGeneration.push_back(sum / size);
+    }
+}
+
+void DesignOptimizer::migrate() {
+    const size_t count = static_cast<size_t>(config.migrants);
+    if (count == 0 || islands.size() < 2) return;
+    // Emigrants are copied before any island changes, so the order islands are visited in does not matter.
+    std::vector<std::vector<OptimizerCandidate>> emigrants;
+    for (const auto& island : islands) emigrants.emplace_back(island.population.begin(), island.population.begin() + count);
+    for (size_t i = 0; i < islands.size(); ++i) {
+        std::vector<OptimizerCandidate>& target = islands[(i + 1) % islands.size()].population;
+        std::copy(emigrants[i].begin(), emigrants[i].end(), target.end() - count);
+        std::stable_sort(target.begin(), target.end(), fitter);
+    }
+}
+
+std::vector<OptimizerProgress> DesignOptimizer::advance() {
+    int steps = std::min(config.migrationInterval, config.generations - currentGeneration);
+    if (steps <= 0) return {};
+
+    // Slot t evolves islands t, t + slots, ...; the calling thread takes a slot too.
+    size_t slots = config.threads > 0 ? config.threads : pool.threadCount() + 1;
+    slots = std::min(slots, islands.size());
+    pool.parallelFor(slots, slots, [&](size_t slot) {
+        for (size_t i = slot; i < islands.size(); i += slots) evolve(islands[i], steps);
+    });
+
+    std::vector<OptimizerProgress> progress(steps);
+    for (int step = 0; step < steps; ++step) {
+        OptimizerProgress& record = progress[step];
+        record.generation = currentGeneration + step + 1;
+        record.bestFitness = islands.front().bestByGeneration[step];
+        for (const auto& island : islands) {
+            record.bestFitness = std::max(record.bestFitness, island.bestByGeneration[step]);
+            record.meanFitness += island.meanByGeneration[step] / islands.size();
+        }
+    }
+    for (auto& island : islands) {
+        island.bestByGeneration.clear();
+        island.meanByGeneration.clear();
+    }
+    currentGeneration += steps;
+    if (!finished()) migrate();
+    return progress;
+}
+
+std::vector<OptimizerCandidate> DesignOptimizer::best(size_t count) const {
+    std::vector<OptimizerCandidate> result;
+    for (const auto& island : islands) mergeElite(result, island.elite, count);
+    return result;
+}
@@ -0,0 +1,86 @@
+#ifndef DESIGNOPTIMIZER_H
+#define DESIGNOPTIMIZER_H
+
+#include "CarDesign.h"
+#include "TaskRuntime.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fitness = speed * speedWeight - fuel * fuelWeight - cost * costWeight, each
+// metric first scaled to [0, 1] over the range the part catalogs allow.
+struct ObjectiveWeights {
+    double speed{1.0};
+    double fuel{0.0};
+    double cost{0.0};
+};
+
+struct OptimizerConfig {
+    ObjectiveWeights weights;
+    int islands{8};
+    int population{64};          // per island
+    int generations{200};
+    int migrationInterval{10};   // generations between migrations
+    int migrants{2};             // best designs each island sends to the next
+    double mutationRate{0.15};   // per gene
+    double aeroSigma{0.05};      // standard deviation of an aero mutation
+    uint64_t seed{1};
+    size_t threads{0};           // 0 uses every pool worker; does not change results
+};
+
+struct OptimizerCandidate {
+    DesignParameters params;
+    DesignMetrics metrics;
+    double fitness{0.0};
+};
+
+struct OptimizerProgress {
+    int generation{0};
+    double bestFitness{0.0};  // best design found so far
+    double meanFitness{0.0};  // over every island's current population
+};
+
+// Island-model genetic search over part indices and continuous aero
+// factors. Each island evolves its own population with tournament
+// selection, uniform crossover, per-gene mutation and elitism, from its own
+// random stream; every migrationInterval generations the islands stop and
+// each one's best designs replace the worst of the next island in a ring.
+// Islands run in parallel on a thread pool between migrations, each worker
+// slot always evolving the same islands, and a given config and seed always
+// produce the same results whatever the thread count.
+class DesignOptimizer {
+public:
+    explicit DesignOptimizer(const OptimizerConfig& config, ThreadPoolExecutor& pool = ThreadPoolExecutor::shared());
+
+    double fitness(const DesignMetrics& metrics) const;
+    int generation() const { return currentGeneration; }
+    bool finished() const { return currentGeneration >= config.generations; }
+    // Evolves every island to the next migration (or the last generation),
+    // then migrates. Returns one progress record per generation run.
+    std::vector<OptimizerProgress> advance();
+    // The best distinct designs seen so far, best first.
+    std::vector<OptimizerCandidate> best(size_t count) const;
+
+private:
+    struct Island {
+        std::vector<OptimizerCandidate> population;  // sorted best first
+        std::vector<OptimizerCandidate> elite;       // best distinct designs seen, best first
+        uint64_t rng{0};
+        std::vector<double> bestByGeneration;
+        std::vector<double> meanByGeneration;
+    };
+
+    OptimizerCandidate makeCandidate(const DesignParameters& params) const;
+    DesignParameters randomDesign(uint64_t& rng) const;
+    void evolve(Island& island, int generations) const;
+    void migrate();
+
+    OptimizerConfig config;
+    ThreadPoolExecutor& pool;
+    int partCounts[4];
+    double speedMin, speedRange, fuelMin, fuelRange, costMin, costRange;
+    std::vector<Island> islands;
+    int currentGeneration{0};
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "DesignVersionHistory.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+const char HISTORY_MAGIC[4] = {'F', '1', 'V', 'H'};
+const uint32_t HISTORY_FORMAT = 1;
+const size_t HEADER_SIZE = sizeof(HISTORY_MAGIC) + sizeof(HISTORY_FORMAT);
+const uint8_t FULL_MASK = 0xFF;
+
+// Record layout (native byte order):
+//   uint8 mask | uint32 number | int64 timestamp |
+//   uint8 part per set bit 0-3 | double aero per set bit 4-7 | uint16 record size
+struct Record {
+    uint8_t mask{0};
+    uint32_t number{0};
+    int64_t timestamp{0};
+    DesignParameters values;
+};
+
+size_t recordSize(uint8_t mask) {
+    size_t size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint16_t);
+    for (int field = 0; field < 8; ++field) {
+        if (mask & (1u << field)) size += field < 4 ? sizeof(uint8_t) : sizeof(double);
+    }
+    return size;
+}
+
+std::string encodeRecord(const Record& record) {
+    std::string out(recordSize(record.mask), '\0');
+    char* p = &out[0];
+    auto put = [&p](const void* value, size_t size) {
+        std::memcpy(p, value, size);
+        p += size;
+    };
+    put(&record.mask, sizeof(record.mask));
+    put(&record.number, sizeof(record.number));
+    put(&record.timestamp, sizeof(record.timestamp));
+    for (int field = 0; field < 4; ++field) {
+        if (record.mask & (1u << field)) {
+            uint8_t part = static_cast<uint8_t>(record.values.parts[field]);
+            put(&part, sizeof(part));
+        }
+    }
+    for (int field = 4; field < 8; ++field) {
+        if (record.mask & (1u << field)) put(&record.values.aero[field - 4], sizeof(double));
+    }
+    uint16_t size = static_cast<uint16_t>(out.size());
+    put(&size, sizeof(size));
+    return out;
+}
+
+Record decodeRecord(const char* data, size_t available) {
+    Record record;
+    if (available < 1) throw std::runtime_error("Corrupted design history");
+    std::memcpy(&record.mask, data, sizeof(record.mask));
+    size_t size = recordSize(record.mask);
+    uint16_t storedSize = 0;
+    if (available < size) throw std::runtime_error("Corrupted design history");
+    std::memcpy(&storedSize, data + size - sizeof(storedSize), sizeof(storedSize));
+    if (storedSize != size) throw std::runtime_error("Corrupted design history");
+    const char* p = data + sizeof(record.mask);
+    std::memcpy(&record.number, p, sizeof(record.number));
+    p += sizeof(record.number);
+    std::memcpy(&record.timestamp, p, sizeof(record.timestamp));
+    p += sizeof(record.timestamp);
+    for (int field = 0; field < 4; ++field) {
+        if (record.mask & (1u << field)) {
+            record.values.parts[field] = static_cast<uint8_t>(*p);
+            p += sizeof(uint8_t);
+        }
+    }
+    for (int field = 4; field < 8; ++field) {
+        if (record.mask & (1u << field)) {
+            std::memcpy(&record.values.aero[field - 4], p, sizeof(double));
+            p += sizeof(double);
+        }
+    }
+    return record;
+}
+
+// Length of the intact part of a history file: the header and every record
+// up to the first one cut short or with a bad trailer, whose start offsets go
+// to offsets. A header cut short counts as nothing; one that is not a history
+// header throws.
+size_t intactLength(const std::string& data, std::vector<uint64_t>& offsets) {
+    offsets.clear();
+    if (data.size() < HEADER_SIZE) {
+        if (std::memcmp(data.data(), HISTORY_MAGIC, std::min(data.size(), sizeof(HISTORY_MAGIC))) != 0) {
+            throw std::runtime_error("Corrupted design history");
+        }
+        return 0;
+    }
+    if (std::memcmp(data.data(), HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) != 0) throw std::runtime_error("Corrupted design history");
+    size_t offset = HEADER_SIZE;
+    while (offset < data.size()) {
+        try {
+            decodeRecord(data.data() + offset, data.size() - offset);
+        } catch (const std::runtime_error& e) {
+            break;
+        }
+        offsets.push_back(offset);
+        offset += recordSize(static_cast<uint8_t>(data[offset]));
+    }
+    return offset;
+}
+
+void applyRecord(const Record& record, DesignParameters& state) {
+    for (int field = 0; field < 4; ++field) {
+        if (record.mask & (1u << field)) state.parts[field] = record.values.parts[field];
+    }
+    for (int field = 4; field < 8; ++field) {
+        if (record.mask & (1u << field)) state.aero[field - 4] = record.values.aero[field - 4];
+    }
+}
+
+}
+
+DesignVersionHistory::DesignVersionHistory(const std::string& designName)
+    : path(historyPath(designName)) {}
+
+std::string DesignVersionHistory::historyPath(const std::string& designName) {
+    return "designs/" + designName + ".f1history";
+}
+
+const char* DesignVersionHistory::fieldName(int field) {
+    static const char* names[8] = {"FrontWing", "RearWing", "Diffuser", "Sidepods",
+                                   "FrontWingAero", "RearWingAero", "DiffuserAero", "SidepodsAero"};
+    return field >= 0 && field < 8 ? names[field] : "";
+}
+
+std::vector<ParameterDiff> DesignVersionHistory::diff(const DesignParameters& from, const DesignParameters& to) {
+    std::vector<ParameterDiff> changes;
+    for (int field = 0; field < 4; ++field) {
+        if (from.parts[field] != to.parts[field]) changes.push_back({field, double(from.parts[field]), double(to.parts[field])});
+    }
+    for (int field = 4; field < 8; ++field) {
+        if (from.aero[field - 4] != to.aero[field - 4]) changes.push_back({field, from.aero[field - 4], to.aero[field - 4]});
+    }
+    return changes;
+}
+
+std::vector<ParameterDiff> DesignVersionHistory::diff(size_t from, size_t to) const {
+    return diff(getVersion(from).params, getVersion(to).params);
+}
+
+bool DesignVersionHistory::readLatest(uint32_t& number, DesignParameters& params) const {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamoff end = file.tellg();
+    if (end <= static_cast<std::streamoff>(HEADER_SIZE)) return false;
+
+    // Walk back over record trailers until a self-contained record is found.
+    std::vector<Record> chain;
+    std::streamoff position = end;
+    char buffer[64];
+    while (position > static_cast<std::streamoff>(HEADER_SIZE)) {
+        uint16_t size = 0;
+        file.seekg(position - static_cast<std::streamoff>(sizeof(size)));
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file || size > sizeof(buffer) || position - size < static_cast<std::streamoff>(HEADER_SIZE)) {
+            throw std::runtime_error("Corrupted design history");
+        }
+        position -= size;
+        file.seekg(position);
+        file.read(buffer, size);
+        chain.push_back(decodeRecord(buffer, size));
+        if (chain.back().mask == FULL_MASK) break;
+    }
+    if (chain.back().mask != FULL_MASK) throw std::runtime_error("Corrupted design history");
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) applyRecord(*it, params);
+    number = chain.front().number;
+    return true;
+}
+
+std::string DesignVersionHistory::readFile() const {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return std::string();
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void DesignVersionHistory::truncateTornTail() const {
+    std::string data = readFile();
+    std::vector<uint64_t> intact;
+    size_t length = intactLength(data, intact);
+    if (length < data.size()) std::filesystem::resize_file(path, length);
+    indexLoaded = false;
+}
+
+bool DesignVersionHistory::append(const DesignParameters& params) {
+    uint32_t latestNumber = 0;
+    DesignParameters latest;
+    bool hasVersions;
+    try {
+        hasVersions = readLatest(latestNumber, latest);
+    } catch (const std::runtime_error& e) {
+        // Most likely the previous append was cut short; drop what it left.
+        truncateTornTail();
+        latest = DesignParameters();
+        hasVersions = readLatest(latestNumber, latest);
+    }
+    if (hasVersions && latest == params) return false;
+
+    Record record;
+    record.number = hasVersions ? latestNumber + 1 : 0;
+    record.timestamp = static_cast<int64_t>(std::time(nullptr));
+    record.values = params;
+    if (!hasVersions || record.number % KEYFRAME_INTERVAL == 0) {
+        record.mask = FULL_MASK;
+    } else {
+        for (const auto& change : diff(latest, params)) record.mask |= static_cast<uint8_t>(1u << change.field);
+    }
+
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) size = 0;
+    if (size > 0 && size < HEADER_SIZE) {
+        // The header itself was cut short, so the file holds no version yet.
+        truncateTornTail();
+        size = 0;
+    }
+    bool needsHeader = size == 0;
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file.is_open()) throw std::runtime_error("Failed to write design history");
+    if (needsHeader) {
+        file.write(HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+        file.write(reinterpret_cast<const char*>(&HISTORY_FORMAT), sizeof(HISTORY_FORMAT));
+    }
+    std::string encoded = encodeRecord(record);
+    file.write(encoded.data(), encoded.size());
+    if (!file) throw std::runtime_error("Failed to write design history");
+    indexLoaded = false;
+    return true;
+}
+
+void DesignVersionHistory::loadIndex() const {
+    if (indexLoaded) return;
+    intactLength(readFile(), offsets);
+    indexLoaded = true;
+}
+
+size_t DesignVersionHistory::versionCount() const {
+    loadIndex();
+    return offsets.size();
+}
+
+DesignVersion DesignVersionHistory::getVersion(size_t number) const {
+    loadIndex();
+    if (number >= offsets.size()) throw std::out_of_range("Design version out of range");
+    size_t first = number - number % KEYFRAME_INTERVAL;
+    uint64_t begin = offsets[first];
+    uint64_t end = number + 1 < offsets.size() ? offsets[number + 1] : 0;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("Failed to read design history");
+    if (end == 0) {
+        file.seekg(0, std::ios::end);
+        end = static_cast<uint64_t>(file.tellg());
+    }
+    std::string data(static_cast<size_t>(end - begin), '\0');
+    file.seekg(static_cast<std::streamoff>(begin));
+    file.read(&data[0], data.size());
+    if (!file) throw std::runtime_error("Failed to read design history");
+
+    DesignVersion version;
+    for (size_t i = first; i <= number; ++i) {
+        Record record = decodeRecord(data.data() + (offsets[i] - begin), data.size() - (offsets[i] - begin));
+        if (i == first && record.mask != FULL_MASK) throw std::runtime_error("Corrupted design history");
+        applyRecord(record, version.params);
+        version.number = record.number;
+        version.timestamp = record.timestamp;
+    }
+    return version;
+}
+
+std::vector<DesignVersion> DesignVersionHistory::getVersions() const {
+    std::string data = readFile();
+    intactLength(data, offsets);
+    indexLoaded = true;
+    std::vector<DesignVersion> versions;
+    versions.reserve(offsets.size());
+    DesignVersion version;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        Record record = decodeRecord(data.data() + offsets[i], data.size() - offsets[i]);
+        if (i == 0 && record.mask != FULL_MASK) throw std::runtime_error("Corrupted design history");
+        applyRecord(record, version.params);
+        version.number = record.number;
+        version.timestamp = record.timestamp;
+        versions.push_back(version);
+    }
+    return versions;
+}
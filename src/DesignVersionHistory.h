@@ -0,0 +1,60 @@
+#ifndef DESIGNVERSIONHISTORY_H
+#define DESIGNVERSIONHISTORY_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct DesignVersion {
+    uint32_t number{0};
+    int64_t timestamp{0};
+    DesignParameters params;
+};
+
+struct ParameterDiff {
+    int field;  // 0-3 part index, 4-7 aero factor, see DesignVersionHistory::fieldName
+    double before;
+    double after;
+};
+
+// Append-only version log kept next to a design as designs/<name>.f1history.
+//
+// Each saved version is one record holding only the fields that changed since
+// the previous version; every KEYFRAME_INTERVAL-th version stores all fields,
+// so rebuilding any version reads at most KEYFRAME_INTERVAL records. Records
+// end with their own length, letting append() find the latest state by
+// reading backwards from the end of the file instead of replaying it.
+// A record torn by a crash mid-append is ignored by readers and cut off by
+// the next append, so the versions before it survive.
+class DesignVersionHistory {
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = 16;
+
+    explicit DesignVersionHistory(const std::string& designName);
+
+    // Appends params as a new version. Returns false if it equals the latest one.
+    bool append(const DesignParameters& params);
+    size_t versionCount() const;
+    DesignVersion getVersion(size_t number) const;
+    // Every version, oldest first, decoded in one pass over the file.
+    std::vector<DesignVersion> getVersions() const;
+    std::vector<ParameterDiff> diff(size_t from, size_t to) const;
+
+    static std::vector<ParameterDiff> diff(const DesignParameters& from, const DesignParameters& to);
+    static const char* fieldName(int field);
+    static std::string historyPath(const std::string& designName);
+
+private:
+    void loadIndex() const;
+    std::string readFile() const;
+    bool readLatest(uint32_t& number, DesignParameters& params) const;
+    void truncateTornTail() const;
+
+    std::string path;
+    mutable std::vector<uint64_t> offsets;
+    mutable bool indexLoaded{false};
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "EvaluationClient.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace EvaluationProtocol;
+
+#ifndef _WIN32
+
+EvaluationClient::EvaluationClient(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path");
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("Failed to create client socket");
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to connect to evaluation server at " + socketPath);
+    }
+}
+
+EvaluationClient::~EvaluationClient() {
+    if (fd >= 0) close(fd);
+}
+
+void EvaluationClient::flush() {
+    size_t offset = 0;
+    while (offset < output.size()) {
+        ssize_t sent = send(fd, output.data() + offset, output.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) throw std::runtime_error("Connection to evaluation server lost");
+        offset += static_cast<size_t>(sent);
+    }
+    output.clear();
+}
+
+EvaluationResponse EvaluationClient::receive() {
+    flush();
+    while (true) {
+        size_t available = input.size() - inputOffset;
+        if (available >= sizeof(FrameHeader)) {
+            FrameHeader header;
+            std::memcpy(&header, input.data() + inputOffset, sizeof(header));
+            if (available >= sizeof(header) + header.length) {
+                EvaluationResponse response;
+                response.requestId = header.requestId;
+                response.op = header.op;
+                response.status = header.status;
+                response.payload.assign(input, inputOffset + sizeof(header), header.length);
+                inputOffset += sizeof(header) + header.length;
+                if (inputOffset == input.size()) {
+                    input.clear();
+                    inputOffset = 0;
+                }
+                return response;
+            }
+        }
+        if (inputOffset > 0) {
+            input.erase(0, inputOffset);
+            inputOffset = 0;
+        }
+        char buffer[64 * 1024];
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) throw std::runtime_error("Connection to evaluation server lost");
+        input.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+#else
+
+EvaluationClient::EvaluationClient(const std::string&) {
+    throw std::runtime_error("The evaluation client requires Unix domain sockets");
+}
+EvaluationClient::~EvaluationClient() = default;
+void EvaluationClient::flush() {}
+EvaluationResponse EvaluationClient::receive() { return {}; }
+
+#endif
+
+uint32_t EvaluationClient::queue(uint8_t op, const std::string& payload) {
+    if (payload.size() > MAX_PAYLOAD) throw std::invalid_argument("Request too large");
+    uint32_t requestId = nextRequestId++;
+    appendFrame(output, requestId, op, STATUS_OK, payload.data(), static_cast<uint32_t>(payload.size()));
+    return requestId;
+}
+
+uint32_t EvaluationClient::sendEvaluate(const DesignParameters* designs, size_t count) {
+    std::string payload(count * sizeof(WireDesign), '\0');
+    for (size_t i = 0; i < count; ++i) {
+        WireDesign wire = toWire(designs[i]);
+        std::memcpy(&payload[i * sizeof(WireDesign)], &wire, sizeof(wire));
+    }
+    return queue(OP_EVALUATE, payload);
+}
+
+uint32_t EvaluationClient::sendCompare(const DesignParameters& a, const DesignParameters& b) {
+    WireDesign wire[2] = {toWire(a), toWire(b)};
+    return queue(OP_COMPARE, std::string(reinterpret_cast<const char*>(wire), sizeof(wire)));
+}
+
+uint32_t EvaluationClient::sendLoad(const std::string& name) {
+    return queue(OP_LOAD, name);
+}
+
+uint32_t EvaluationClient::sendSave(const DesignParameters& design, const std::string& name) {
+    WireDesign wire = toWire(design);
+    return queue(OP_SAVE, std::string(reinterpret_cast<const char*>(&wire), sizeof(wire)) + name);
+}
+
+EvaluationResponse EvaluationClient::expect(uint32_t requestId) {
+    EvaluationResponse response = receive();
+    if (response.requestId != requestId) throw std::runtime_error("Out-of-order response from evaluation server");
+    if (!response.ok()) throw std::runtime_error(response.error());
+    return response;
+}
+
+std::vector<DesignMetrics> EvaluationClient::evaluate(const std::vector<DesignParameters>& designs) {
+    EvaluationResponse response = expect(sendEvaluate(designs.data(), designs.size()));
+    std::vector<DesignMetrics> metrics(response.payload.size() / sizeof(WireMetrics));
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        WireMetrics wire;
+        std::memcpy(&wire, response.payload.data() + i * sizeof(WireMetrics), sizeof(wire));
+        metrics[i] = fromWire(wire);
+    }
+    return metrics;
+}
+
+DesignParameters EvaluationClient::load(const std::string& name) {
+    EvaluationResponse response = expect(sendLoad(name));
+    if (response.payload.size() != sizeof(WireDesign)) throw std::runtime_error("Malformed load response");
+    WireDesign wire;
+    std::memcpy(&wire, response.payload.data(), sizeof(wire));
+    return fromWire(wire);
+}
+
+void EvaluationClient::save(const DesignParameters& design, const std::string& name) {
+    expect(sendSave(design, name));
+}
+
+LoadGeneratorReport runLoadGenerator(const std::string& socketPath, const LoadGeneratorSpec& spec) {
+    if (spec.connections < 1 || spec.pipelineDepth < 1 || spec.batchSize < 1) {
+        throw std::invalid_argument("Load generator needs at least one connection, request and design");
+    }
+    using Clock = std::chrono::steady_clock;
+    struct WorkerResult {
+        uint64_t requests{0};
+        uint64_t errors{0};
+        std::vector<float> latencies;
+        std::string failure;
+    };
+
+    // Connect everything up front so a missing server fails fast.
+    std::vector<std::unique_ptr<EvaluationClient>> clients;
+    for (int i = 0; i < spec.connections; ++i) clients.push_back(std::make_unique<EvaluationClient>(socketPath));
+
+    std::vector<WorkerResult> results(spec.connections);
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spec.seconds));
+    std::vector<std::thread> threads;
+    for (int c = 0; c < spec.connections; ++c) {
+        threads.emplace_back([&, c]() {
+            EvaluationClient& client = *clients[c];
+            WorkerResult& result = results[c];
+            std::mt19937 rng(1234 + c);
+            std::uniform_real_distribution<double> aero(0.5, 1.5);
+            std::vector<DesignParameters> batch(spec.batchSize);
+            for (auto& design : batch) {
+                design.parts[0] = static_cast<int>(rng() % FrontWing::getDesignCount());
+                design.parts[1] = static_cast<int>(rng() % RearWing::getDesignCount());
+                design.parts[2] = static_cast<int>(rng() % Diffuser::getDesignCount());
+                design.parts[3] = static_cast<int>(rng() % Sidepods::getDesignCount());
+                for (double& factor : design.aero) factor = aero(rng);
+            }
+            std::deque<Clock::time_point> sentAt;
+            try {
+                while (true) {
+                    bool sending = Clock::now() < deadline;
+                    while (sending && sentAt.size() < static_cast<size_t>(spec.pipelineDepth)) {
+                        client.sendEvaluate(batch.data(), batch.size());
+                        sentAt.push_back(Clock::now());
+                    }
+                    if (sentAt.empty()) break;
+                    EvaluationResponse response = client.receive();
+                    result.latencies.push_back(std::chrono::duration<float, std::micro>(Clock::now() - sentAt.front()).count());
+                    sentAt.pop_front();
+                    if (response.ok()) ++result.requests;
+                    else ++result.errors;
+                }
+            } catch (const std::exception& e) {
+                result.failure = e.what();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    LoadGeneratorReport report;
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::vector<float> latencies;
+    for (const auto& result : results) {
+        if (!result.failure.empty()) throw std::runtime_error(result.failure);
+        report.requests += result.requests;
+        report.errors += result.errors;
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    report.designs = report.requests * static_cast<uint64_t>(spec.batchSize);
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        report.p50Micros = latencies[latencies.size() / 2];
+        report.p99Micros = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        report.maxMicros = latencies.back();
+    }
+    return report;
+}
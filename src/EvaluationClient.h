@@ -0,0 +1,76 @@
+#ifndef EVALUATIONCLIENT_H
+#define EVALUATIONCLIENT_H
+
+#include "EvaluationProtocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EvaluationResponse {
+    uint32_t requestId{0};
+    uint8_t op{0};
+    uint8_t status{0};
+    std::string payload;
+
+    bool ok() const { return status == EvaluationProtocol::STATUS_OK; }
+    std::string error() const { return ok() ? std::string() : payload; }
+};
+
+// Blocking client for the evaluation server (POSIX only).
+//
+// The send* calls only queue a frame and return its request id; flush()
+// writes everything queued and receive() reads the next response, so callers
+// can keep many requests in flight on one connection. The blocking helpers
+// send one request and wait for its answer.
+class EvaluationClient {
+public:
+    explicit EvaluationClient(const std::string& socketPath);
+    ~EvaluationClient();
+    EvaluationClient(const EvaluationClient&) = delete;
+    EvaluationClient& operator=(const EvaluationClient&) = delete;
+
+    uint32_t sendEvaluate(const DesignParameters* designs, size_t count);
+    uint32_t sendCompare(const DesignParameters& a, const DesignParameters& b);
+    uint32_t sendLoad(const std::string& name);
+    uint32_t sendSave(const DesignParameters& design, const std::string& name);
+    void flush();
+    EvaluationResponse receive();
+
+    std::vector<DesignMetrics> evaluate(const std::vector<DesignParameters>& designs);
+    DesignParameters load(const std::string& name);
+    void save(const DesignParameters& design, const std::string& name);
+
+private:
+    uint32_t queue(uint8_t op, const std::string& payload);
+    EvaluationResponse expect(uint32_t requestId);
+
+    int fd{-1};
+    uint32_t nextRequestId{1};
+    std::string output;
+    std::string input;
+    size_t inputOffset{0};
+};
+
+struct LoadGeneratorSpec {
+    int connections{4};
+    int pipelineDepth{16};     // requests in flight per connection
+    int batchSize{256};        // designs per EVALUATE request
+    double seconds{5.0};
+};
+
+struct LoadGeneratorReport {
+    uint64_t requests{0};
+    uint64_t designs{0};
+    uint64_t errors{0};
+    double seconds{0.0};
+    double p50Micros{0.0};
+    double p99Micros{0.0};
+    double maxMicros{0.0};
+};
+
+// Drives a running server with random EVALUATE batches, one thread per
+// connection, and reports throughput and request latency.
+LoadGeneratorReport runLoadGenerator(const std::string& socketPath, const LoadGeneratorSpec& spec);
+
+#endif
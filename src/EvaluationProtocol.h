@@ -0,0 +1,101 @@
+#ifndef EVALUATIONPROTOCOL_H
+#define EVALUATIONPROTOCOL_H
+
+#include "CarDesign.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Binary protocol spoken by the evaluation server over a Unix domain socket.
+//
+// Every message is a FrameHeader followed by `length` payload bytes, in native
+// byte order (client and server share the machine). Clients may pipeline any
+// number of requests; responses come back in request order and echo the
+// request id.
+//
+//   EVALUATE  request: count x WireDesign      response: count x WireMetrics
+//   COMPARE   request: 2 x WireDesign          response: 3 x WireMetrics (a, b, percent difference)
+//   LOAD      request: design name             response: 1 x WireDesign
+//   SAVE      request: WireDesign + name       response: empty
+// A response with a non-OK status carries an error message as its payload.
+namespace EvaluationProtocol {
+
+enum Op : uint8_t {
+    OP_EVALUATE = 1,
+    OP_COMPARE = 2,
+    OP_LOAD = 3,
+    OP_SAVE = 4
+};
+
+enum Status : uint8_t {
+    STATUS_OK = 0,
+    STATUS_BAD_REQUEST = 1,
+    STATUS_FAILED = 2
+};
+
+const uint32_t MAX_PAYLOAD = 16u << 20;
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    uint32_t length;
+    uint32_t requestId;
+    uint8_t op;
+    uint8_t status;
+    uint16_t reserved;
+};
+
+struct WireDesign {
+    uint8_t parts[4];
+    double aero[4];
+};
+
+struct WireMetrics {
+    double drag;
+    double mass;
+    double cost;
+    double speed;
+    double fuelConsumption;
+};
+#pragma pack(pop)
+
+inline WireDesign toWire(const DesignParameters& params) {
+    WireDesign wire;
+    for (int i = 0; i < 4; ++i) {
+        wire.parts[i] = static_cast<uint8_t>(params.parts[i]);
+        wire.aero[i] = params.aero[i];
+    }
+    return wire;
+}
+
+inline DesignParameters fromWire(const WireDesign& wire) {
+    DesignParameters params;
+    for (int i = 0; i < 4; ++i) {
+        params.parts[i] = wire.parts[i];
+        params.aero[i] = wire.aero[i];
+    }
+    return params;
+}
+
+inline WireMetrics toWire(const DesignMetrics& metrics) {
+    return {metrics.attributes.drag, metrics.attributes.mass, metrics.attributes.cost,
+            metrics.speed, metrics.fuelConsumption};
+}
+
+inline DesignMetrics fromWire(const WireMetrics& wire) {
+    DesignMetrics metrics;
+    metrics.attributes = {wire.drag, wire.mass, wire.cost};
+    metrics.speed = wire.speed;
+    metrics.fuelConsumption = wire.fuelConsumption;
+    return metrics;
+}
+
+inline void appendFrame(std::string& out, uint32_t requestId, uint8_t op, uint8_t status,
+                        const void* payload, uint32_t length) {
+    FrameHeader header{length, requestId, op, status, 0};
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (length > 0) out.append(static_cast<const char*>(payload), length);
+}
+
+}
+
+#endif
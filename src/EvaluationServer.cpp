@@ -0,0 +1,331 @@
+#include "EvaluationServer.h"
+#include "ConfigurationManager.h"
+#include "TraceRecorder.h"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace EvaluationProtocol;
+
+namespace {
+
+const size_t READ_CHUNK = 64 * 1024;
+const size_t MAX_PENDING_OUTPUT = 32u << 20;  // stop reading a connection beyond this
+
+void appendError(std::string& out, const FrameHeader& request, uint8_t status, const std::string& message) {
+    appendFrame(out, request.requestId, request.op, status, message.data(), static_cast<uint32_t>(message.size()));
+}
+
+}
+
+struct EvaluationServer::Connection {
+    int fd{-1};
+    std::string input;
+    size_t inputOffset{0};
+    std::string output;
+    size_t outputOffset{0};
+    bool peerClosed{false};
+    uint32_t interest{0};
+};
+
+#ifdef __linux__
+
+EvaluationServer::EvaluationServer(const std::string& socketPath) : socketPath(socketPath) {
+    sockaddr_un address{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path");
+    }
+    // Replace a stale socket left by a previous run, but never a regular file.
+    struct stat info;
+    if (lstat(socketPath.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) throw std::runtime_error("Socket path exists and is not a socket");
+        unlink(socketPath.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) throw std::runtime_error("Failed to create server socket");
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+        close(listenFd);
+        throw std::runtime_error("Failed to bind server socket");
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        close(listenFd);
+        if (epollFd >= 0) close(epollFd);
+        if (wakeFd >= 0) close(wakeFd);
+        unlink(socketPath.c_str());
+        throw std::runtime_error("Failed to create event loop");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+EvaluationServer::~EvaluationServer() {
+    for (auto& entry : connections) close(entry.first);
+    connections.clear();
+    close(wakeFd);
+    close(epollFd);
+    close(listenFd);
+    unlink(socketPath.c_str());
+}
+
+void EvaluationServer::stop() {
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void EvaluationServer::run() {
+    std::vector<epoll_event> events(256);
+    bool running = true;
+    while (running) {
+        int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Event loop failed");
+        }
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                running = false;
+                continue;
+            }
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = *it->second;
+            bool alive = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                alive = readInput(connection);
+                if (alive) processFrames(connection);
+            }
+            if (alive) alive = flushOutput(connection);
+            if (alive && connection.peerClosed && connection.outputOffset == connection.output.size()) alive = false;
+            if (alive) updateInterest(connection);
+            else closeConnection(fd);
+        }
+    }
+}
+
+void EvaluationServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN or a transient error; epoll reports the next one
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->interest = EPOLLIN;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        connections.emplace(fd, std::move(connection));
+    }
+}
+
+void EvaluationServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
+
+bool EvaluationServer::readInput(Connection& connection) {
+    if (connection.output.size() - connection.outputOffset > MAX_PENDING_OUTPUT) return true;
+    while (true) {
+        size_t used = connection.input.size();
+        connection.input.resize(used + READ_CHUNK);
+        ssize_t received = recv(connection.fd, &connection.input[used], READ_CHUNK, 0);
+        connection.input.resize(used + (received > 0 ? static_cast<size_t>(received) : 0));
+        if (received > 0) continue;
+        if (received == 0) {
+            connection.peerClosed = true;
+            return true;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+void EvaluationServer::processFrames(Connection& connection) {
+    while (connection.input.size() - connection.inputOffset >= sizeof(FrameHeader)) {
+        FrameHeader header;
+        std::memcpy(&header, connection.input.data() + connection.inputOffset, sizeof(header));
+        if (header.length > MAX_PAYLOAD) {
+            appendError(connection.output, header, STATUS_BAD_REQUEST, "Frame too large");
+            connection.peerClosed = true;  // cannot resynchronise the stream
+            connection.inputOffset = connection.input.size();
+            break;
+        }
+        if (connection.input.size() - connection.inputOffset < sizeof(header) + header.length) break;
+        handleFrame(connection, header, connection.input.data() + connection.inputOffset + sizeof(header));
+        connection.inputOffset += sizeof(header) + header.length;
+        requests.fetch_add(1, std::memory_order_relaxed);
+        if (connection.output.size() - connection.outputOffset > MAX_PENDING_OUTPUT) break;
+    }
+    connection.input.erase(0, connection.inputOffset);
+    connection.inputOffset = 0;
+}
+
+bool EvaluationServer::flushOutput(Connection& connection) {
+    while (connection.outputOffset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.outputOffset,
+                            connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.outputOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return true;
+        return false;
+    }
+    connection.output.clear();
+    connection.outputOffset = 0;
+    // Frames held back by output backpressure can be answered now.
+    if (!connection.input.empty()) {
+        processFrames(connection);
+        if (!connection.output.empty()) return flushOutput(connection);
+    }
+    return true;
+}
+
+void EvaluationServer::updateInterest(Connection& connection) {
+    bool pendingOutput = connection.outputOffset < connection.output.size();
+    bool backedUp = connection.output.size() - connection.outputOffset > MAX_PENDING_OUTPUT;
+    uint32_t interest = (backedUp || connection.peerClosed ? 0u : static_cast<uint32_t>(EPOLLIN)) |
+                        (pendingOutput ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    if (interest == connection.interest) return;
+    epoll_event event{};
+    event.events = interest;
+    event.data.fd = connection.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.interest = interest;
+}
+
+#else
+
+EvaluationServer::EvaluationServer(const std::string& socketPath) : socketPath(socketPath) {
+    throw std::runtime_error("The evaluation server requires Linux");
+}
+EvaluationServer::~EvaluationServer() = default;
+void EvaluationServer::stop() {}
+void EvaluationServer::run() {}
+void EvaluationServer::acceptConnections() {}
+void EvaluationServer::closeConnection(int) {}
+bool EvaluationServer::readInput(Connection&) { return false; }
+void EvaluationServer::processFrames(Connection&) {}
+bool EvaluationServer::flushOutput(Connection&) { return false; }
+void EvaluationServer::updateInterest(Connection&) {}
+
+#endif
+
+void EvaluationServer::handleFrame(Connection& connection, const FrameHeader& header, const char* payload) {
+    std::string& out = connection.output;
+    try {
+        switch (header.op) {
+        case OP_EVALUATE: {
+            TRACE_ZONE("EvaluationServer evaluate batch");
+            if (header.length % sizeof(WireDesign) != 0) {
+                appendError(out, header, STATUS_BAD_REQUEST, "Malformed design batch");
+                return;
+            }
+            size_t count = header.length / sizeof(WireDesign);
+            size_t start = out.size();
+            out.resize(start + sizeof(FrameHeader) + count * sizeof(WireMetrics));
+            FrameHeader response{static_cast<uint32_t>(count * sizeof(WireMetrics)), header.requestId, header.op, STATUS_OK, 0};
+            std::memcpy(&out[start], &response, sizeof(response));
+            char* metricsOut = &out[start + sizeof(FrameHeader)];
+            for (size_t i = 0; i < count; ++i) {
+                WireDesign design;
+                std::memcpy(&design, payload + i * sizeof(WireDesign), sizeof(design));
+                WireMetrics metrics;
+                try {
+                    metrics = toWire(CarDesign::evaluate(fromWire(design)));
+                } catch (const std::out_of_range&) {
+                    out.resize(start);
+                    appendError(out, header, STATUS_BAD_REQUEST, "Invalid part index in batch");
+                    return;
+                }
+                std::memcpy(metricsOut + i * sizeof(WireMetrics), &metrics, sizeof(metrics));
+            }
+            evaluations.fetch_add(count, std::memory_order_relaxed);
+            return;
+        }
+        case OP_COMPARE: {
+            if (header.length != 2 * sizeof(WireDesign)) {
+                appendError(out, header, STATUS_BAD_REQUEST, "Compare needs two designs");
+                return;
+            }
+            WireDesign designs[2];
+            std::memcpy(designs, payload, sizeof(designs));
+            WireMetrics results[3];
+            results[0] = toWire(CarDesign::evaluate(fromWire(designs[0])));
+            results[1] = toWire(CarDesign::evaluate(fromWire(designs[1])));
+            const double* a = &results[0].drag;
+            const double* b = &results[1].drag;
+            double* difference = &results[2].drag;
+            for (int i = 0; i < 5; ++i) difference[i] = b[i] != 0 ? (a[i] - b[i]) / b[i] * 100 : 0.0;
+            evaluations.fetch_add(2, std::memory_order_relaxed);
+            appendFrame(out, header.requestId, header.op, STATUS_OK, results, sizeof(results));
+            return;
+        }
+        case OP_LOAD: {
+            std::string name(payload, header.length);
+            auto [isValid, error] = CarDesign::validateDesignName(name);
+            if (!isValid) {
+                appendError(out, header, STATUS_BAD_REQUEST, error);
+                return;
+            }
+            CarDesign design;
+            design.loadFromFile(name);
+            WireDesign wire = toWire(design.getParameters());
+            appendFrame(out, header.requestId, header.op, STATUS_OK, &wire, sizeof(wire));
+            return;
+        }
+        case OP_SAVE: {
+            if (header.length <= sizeof(WireDesign)) {
+                appendError(out, header, STATUS_BAD_REQUEST, "Save needs a design and a name");
+                return;
+            }
+            WireDesign wire;
+            std::memcpy(&wire, payload, sizeof(wire));
+            std::string name(payload + sizeof(wire), header.length - sizeof(wire));
+            auto [isValid, error] = CarDesign::validateDesignName(name);
+            if (!isValid) {
+                appendError(out, header, STATUS_BAD_REQUEST, error);
+                return;
+            }
+            CarDesign design;
+            design.setParameters(fromWire(wire));
+            ConfigurationManager::saveDesign(design, name);
+            appendFrame(out, header.requestId, header.op, STATUS_OK, nullptr, 0);
+            return;
+        }
+        default:
+            appendError(out, header, STATUS_BAD_REQUEST, "Unknown operation");
+        }
+    } catch (const std::out_of_range&) {
+        appendError(out, header, STATUS_BAD_REQUEST, "Invalid part index");
+    } catch (const std::exception& e) {
+        appendError(out, header, STATUS_FAILED, e.what());
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef EVALUATIONSERVER_H
+#define EVALUATIONSERVER_H
+
+#include "EvaluationProtocol.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Long-running local evaluation service (Linux only).
+//
+// Listens on a Unix domain socket and serves the EvaluationProtocol from a
+// single epoll loop. Each connection keeps an input and an output buffer: all
+// complete frames in the input are answered in order before the output is
+// flushed, so pipelined requests are batched into few syscalls. A connection
+// whose output backs up stops being read until the client catches up.
+// LOAD and SAVE go through CarDesign/ConfigurationManager on the loop thread.
+class EvaluationServer {
+public:
+    explicit EvaluationServer(const std::string& socketPath);
+    ~EvaluationServer();
+    EvaluationServer(const EvaluationServer&) = delete;
+    EvaluationServer& operator=(const EvaluationServer&) = delete;
+
+    // Serves clients until stop() is called.
+    void run();
+    // Safe to call from other threads and from signal handlers.
+    void stop();
+
+    uint64_t requestsServed() const { return requests.load(std::memory_order_relaxed); }
+    uint64_t designsEvaluated() const { return evaluations.load(std::memory_order_relaxed); }
+
+private:
+    struct Connection;
+    void acceptConnections();
+    void closeConnection(int fd);
+    bool readInput(Connection& connection);
+    void processFrames(Connection& connection);
+    bool flushOutput(Connection& connection);
+    void updateInterest(Connection& connection);
+    void handleFrame(Connection& connection, const EvaluationProtocol::FrameHeader& header, const char* payload);
+
+    std::string socketPath;
+    int listenFd{-1};
+    int epollFd{-1};
+    int wakeFd{-1};
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> evaluations{0};
+};
+
+#endif
@@ -0,0 +1,633 @@
+#include "HeadlessCommands.h"
+#include "BulkEdit.h"
+#include "CompactDesign.h"
+#include "ConfigurationManager.h"
+#include "CpuTopology.h"
+#include "DesignOptimizer.h"
+#include "DesignVersionHistory.h"
+#include "EvaluationClient.h"
+#include "EvaluationServer.h"
+#include "LibraryIndex.h"
+#include "LibraryTransfer.h"
+#include "ResultCache.h"
+#include "ScalingBenchmark.h"
+#include "ShardedSweep.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+    std::cout << "Usage: F1CarDesigner [--trace FILE] [--pin-threads] [command] [options]\n"
+              << "Without a command the designer window opens. --trace records timing zones and writes\n"
+              << "them to FILE in Chrome trace-event format when the program exits. --pin-threads pins\n"
+              << "parallel workers to CPUs spread over the NUMA nodes.\n\n"
+              << "Commands:\n"
+              << "  query [--where COLUMN<OP>VALUE]... [--order COLUMN] [--asc] [--limit N]\n"
+              << "      Ranks saved designs through the library index. OP is <, <=, >, >= or =.\n"
+              << "  similar NAME [--k N] [--within PCT]\n"
+              << "      Lists the N saved designs most like NAME, or with --within every design whose speed\n"
+              << "      and cost are both within PCT percent of NAME's.\n"
+              << "  reindex\n"
+              << "      Rebuilds the library index from the designs directory.\n"
+              << "  sweep [--workers N] [--steps N] [--aero-min X] [--aero-max X] [--samples N]\n"
+              << "        [--tolerance X] [--seed N] [--top K] [--inject-crash N] [--no-cache]\n"
+              << "      Evaluates every catalog combination over an aero grid in worker processes.\n"
+              << "  cache [--clear]\n"
+              << "      Shows or empties the persistent cache of Monte Carlo sweep results.\n"
+              << "  serve [--socket PATH]\n"
+              << "      Serves evaluate, compare, load and save requests on a Unix domain socket.\n"
+              << "  loadgen [--socket PATH] [--connections N] [--depth N] [--batch N] [--seconds X]\n"
+              << "      Benchmarks a running server with pipelined evaluate batches.\n"
+              << "  export FILE\n"
+              << "      Writes every saved design with its metrics to FILE (.csv, otherwise columnar .f1cols).\n"
+              << "  import FILE [--overwrite]\n"
+              << "      Saves every design in FILE; existing designs are kept unless --overwrite is given.\n"
+              << "  rank FILE [--top K]\n"
+              << "      Packs every design in an export file into 8 bytes, drops duplicates and lists the fastest.\n"
+              << "  bulkedit [--where COLUMN<OP>VALUE]... [--set|--cap|--floor|--scale COLUMN=VALUE]...\n"
+              << "           [--dry-run] [--threads N] [--inject-crash N]\n"
+              << "      Edits every matching design in parallel and saves all of them or none. An edit\n"
+              << "      interrupted mid-commit is rolled back by the next bulkedit, dry runs included.\n"
+              << "  optimize [--weights SPEED,FUEL,COST] [--islands N] [--population N] [--generations N]\n"
+              << "           [--migration N] [--seed N] [--threads N] [--top K] [--save PREFIX]\n"
+              << "      Searches part choices and continuous aero factors with a parallel island-model\n"
+              << "      genetic algorithm; --save writes the best K designs as PREFIX1, PREFIX2, ...\n"
+              << "  scale [--threads N] [--designs N] [--seconds X] [--workload evaluate|stats|copy]... [--pin]\n"
+              << "      Measures throughput, parallel efficiency and memory bandwidth of the bulk workloads\n"
+              << "      at 1, 2, 4, ... N threads; --pin pins workers and gives each node-local buffers.\n"
+              << "  telemetry NAME [--points N]\n"
+              << "      Writes the metrics of every saved version of a design as CSV, downsampled to N points.\n";
+}
+
+int runQuery(int argc, char** argv) {
+    IndexQuery query;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--where" && i + 1 < argc) {
+            IndexPredicate predicate;
+            if (!LibraryIndex::parsePredicate(argv[++i], predicate)) {
+                std::cerr << "Invalid predicate: " << argv[i] << std::endl;
+                return 2;
+            }
+            query.predicates.push_back(predicate);
+        } else if (arg == "--order" && i + 1 < argc) {
+            if (!LibraryIndex::parseColumn(argv[++i], query.orderBy)) {
+                std::cerr << "Unknown column: " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "--asc") {
+            query.descending = false;
+        } else if (arg == "--limit" && i + 1 < argc) {
+            query.limit = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    auto start = std::chrono::steady_clock::now();
+    auto results = index.query(query);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-32s %10s %10s %12s %8s %8s\n", "Design", "Speed", "Fuel", "Cost", "Drag", "Mass");
+    for (const auto& row : results) {
+        std::printf("%-32s %10.2f %10.2f %12.2f %8.2f %8.2f\n", row.name.c_str(),
+                    row.get(IndexColumn::SPEED), row.get(IndexColumn::FUEL), row.get(IndexColumn::COST),
+                    row.get(IndexColumn::DRAG), row.get(IndexColumn::MASS));
+    }
+    std::printf("%zu of %zu designs, query %.3f ms\n", results.size(), index.size(), elapsedMs);
+    return 0;
+}
+
+void printCandidate(const SweepCandidate& candidate) {
+    std::printf("  FW %d RW %d DF %d SP %d | aero %.3f %.3f %.3f %.3f | speed %.2f fuel %.2f cost %.0f\n",
+                candidate.params.parts[0], candidate.params.parts[1], candidate.params.parts[2], candidate.params.parts[3],
+                candidate.params.aero[0], candidate.params.aero[1], candidate.params.aero[2], candidate.params.aero[3],
+                candidate.speed, candidate.fuelConsumption, candidate.cost);
+}
+
+int runSweep(int argc, char** argv) {
+    SweepSpec spec;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-cache") {
+            spec.useCache = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        const char* value = argv[++i];
+        if (arg == "--workers") spec.workers = std::atoi(value);
+        else if (arg == "--steps") spec.aeroSteps = std::atoi(value);
+        else if (arg == "--aero-min") spec.aeroMin = std::atof(value);
+        else if (arg == "--aero-max") spec.aeroMax = std::atof(value);
+        else if (arg == "--samples") spec.monteCarloSamples = std::atoi(value);
+        else if (arg == "--tolerance") spec.aeroTolerance = std::atof(value);
+        else if (arg == "--seed") spec.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--top") spec.topK = std::strtoul(value, nullptr, 10);
+        else if (arg == "--inject-crash") spec.crashAfter = std::atoll(value);
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    ShardedSweep sweep(spec);
+    std::cout << "Sweeping " << sweep.candidateCount() << " candidates on " << spec.workers << " workers" << std::endl;
+    SweepReport report = sweep.run();
+    std::printf("Evaluated %llu candidates in %.2f s (%.0f/s), %d shard restarts\n",
+                static_cast<unsigned long long>(report.evaluated), report.seconds,
+                report.seconds > 0 ? report.evaluated / report.seconds : 0.0, report.restarts);
+    if (report.cached > 0) {
+        std::printf("%llu results read from the result cache\n", static_cast<unsigned long long>(report.cached));
+    }
+    std::printf("Top %zu by speed:\n", report.top.size());
+    for (const auto& candidate : report.top) printCandidate(candidate);
+    std::printf("Pareto front (speed, fuel, cost): %zu designs\n", report.pareto.size());
+    for (size_t i = 0; i < report.pareto.size() && i < 10; ++i) printCandidate(report.pareto[i]);
+    std::printf("Speed histogram (%.0f-%.0f km/h):\n", spec.histogramMin, spec.histogramMax);
+    double binWidth = (spec.histogramMax - spec.histogramMin) / report.speedHistogram.size();
+    for (size_t bin = 0; bin < report.speedHistogram.size(); ++bin) {
+        if (report.speedHistogram[bin] == 0) continue;
+        std::printf("  %6.0f-%6.0f %llu\n", spec.histogramMin + bin * binWidth, spec.histogramMin + (bin + 1) * binWidth,
+                    static_cast<unsigned long long>(report.speedHistogram[bin]));
+    }
+    return 0;
+}
+
+const char* DEFAULT_SOCKET = "f1designer.sock";
+EvaluationServer* activeServer = nullptr;
+
+void stopActiveServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+int runServe(int argc, char** argv) {
+    std::string socketPath = DEFAULT_SOCKET;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    EvaluationServer server(socketPath);
+    activeServer = &server;
+    std::signal(SIGINT, stopActiveServer);
+    std::signal(SIGTERM, stopActiveServer);
+    std::cout << "Serving on " << socketPath << " (Ctrl+C to stop)" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    server.run();
+    activeServer = nullptr;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Served %llu requests, %llu evaluations in %.1f s\n",
+                static_cast<unsigned long long>(server.requestsServed()),
+                static_cast<unsigned long long>(server.designsEvaluated()), seconds);
+    return 0;
+}
+
+int runLoadGen(int argc, char** argv) {
+    std::string socketPath = DEFAULT_SOCKET;
+    LoadGeneratorSpec spec;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        const char* value = argv[++i];
+        if (arg == "--socket") socketPath = value;
+        else if (arg == "--connections") spec.connections = std::atoi(value);
+        else if (arg == "--depth") spec.pipelineDepth = std::atoi(value);
+        else if (arg == "--batch") spec.batchSize = std::atoi(value);
+        else if (arg == "--seconds") spec.seconds = std::atof(value);
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::printf("%d connections x %d in flight x %d designs per request for %.1f s\n",
+                spec.connections, spec.pipelineDepth, spec.batchSize, spec.seconds);
+    LoadGeneratorReport report = runLoadGenerator(socketPath, spec);
+    std::printf("%llu requests (%llu errors), %.0f requests/s, %.0f evaluations/s\n",
+                static_cast<unsigned long long>(report.requests), static_cast<unsigned long long>(report.errors),
+                report.requests / report.seconds, report.designs / report.seconds);
+    std::printf("Latency p50 %.0f us, p99 %.0f us, max %.0f us\n", report.p50Micros, report.p99Micros, report.maxMicros);
+    return report.errors == 0 ? 0 : 1;
+}
+
+// Replays a design's saved versions through the telemetry ring, the same
+// path the editor's live plots take, and prints the series as CSV.
+int runTelemetry(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 2;
+    }
+    std::string name = argv[2];
+    size_t maxPoints = 0;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--points" && i + 1 < argc) {
+            maxPoints = static_cast<size_t>(std::max(std::atoi(argv[++i]), 0));
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    auto [isValid, error] = CarDesign::validateDesignName(name);
+    if (!isValid) throw std::invalid_argument(error);
+
+    std::vector<DesignVersion> versions = DesignVersionHistory(name).getVersions();
+    if (versions.empty()) throw std::runtime_error("No saved versions of design " + name);
+    TelemetryRing ring(versions.size() + 1);
+    for (const DesignVersion& version : versions) {
+        ring.push(TelemetrySample::fromMetrics(static_cast<double>(version.timestamp), CarDesign::evaluate(version.params)));
+    }
+    uint64_t cursor = 0;
+    std::vector<TelemetrySample> samples;
+    ring.readSince(cursor, samples);
+    writeTelemetryCsv(std::cout, samples, maxPoints);
+    std::cerr << samples.size() << " versions of " << name << std::endl;
+    return 0;
+}
+
+void printTransferStats(const char* verb, const TransferStats& stats) {
+    std::printf("%s %llu designs (%llu skipped), %.1f MB in %.2f s\n", verb,
+                static_cast<unsigned long long>(stats.rows), static_cast<unsigned long long>(stats.skipped),
+                stats.bytes / 1048576.0, stats.seconds);
+}
+
+int runExport(int argc, char** argv) {
+    if (argc != 3) {
+        printUsage();
+        return 2;
+    }
+    TransferStats stats = LibraryTransfer::exportLibrary(argv[2]);
+    printTransferStats("Exported", stats);
+    std::printf("Design loading: %zu arena allocations (%zu overflowed the arena), %zu global heap allocations\n",
+                stats.allocations.arenaAllocations, stats.allocations.overflowAllocations, stats.allocations.heapAllocations);
+    return 0;
+}
+
+int runImport(int argc, char** argv) {
+    bool overwrite = argc == 4 && std::string(argv[3]) == "--overwrite";
+    if (argc != 3 && !overwrite) {
+        printUsage();
+        return 2;
+    }
+    printTransferStats("Imported", LibraryTransfer::importLibrary(argv[2], overwrite));
+    return 0;
+}
+
+int runRank(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 2;
+    }
+    size_t topK = 10;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            topK = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CompactLibrary library;
+    uint64_t unpackable = 0;
+    DesignTableReader reader(argv[2], LibraryTransfer::formatForPath(argv[2]));
+    std::vector<TransferRow> rows;
+    while (reader.next(rows)) {
+        for (const auto& row : rows) {
+            try {
+                library.add(row.params);
+            } catch (const std::invalid_argument& e) {
+                ++unpackable;
+            }
+        }
+    }
+    auto loaded = std::chrono::steady_clock::now();
+    size_t duplicates = library.deduplicate();
+    std::vector<size_t> fastest = library.fastest(topK);
+    auto ranked = std::chrono::steady_clock::now();
+
+    std::printf("Packed %zu designs into %.1f MB (%llu unreadable, %zu duplicates removed), max aero error %.1e\n",
+                library.size() + duplicates, library.memoryUsage() / 1048576.0,
+                static_cast<unsigned long long>(reader.rejectedRows() + unpackable), duplicates,
+                CompactDesign::MAX_AERO_ERROR);
+    std::printf("Read %.2f s, dedup and rank %.3f s\n", std::chrono::duration<double>(loaded - start).count(),
+                std::chrono::duration<double>(ranked - loaded).count());
+    std::printf("Top %zu by speed:\n", fastest.size());
+    for (size_t index : fastest) {
+        SweepCandidate candidate;
+        candidate.params = CompactDesign::decode(library.at(index));
+        DesignMetrics metrics = CarDesign::evaluate(candidate.params);
+        candidate.speed = metrics.speed;
+        candidate.fuelConsumption = metrics.fuelConsumption;
+        candidate.cost = metrics.attributes.cost;
+        printCandidate(candidate);
+    }
+    return 0;
+}
+
+int runBulkEdit(int argc, char** argv) {
+    BulkEditSpec spec;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        BulkOperation operation;
+        if (arg == "--where" && i + 1 < argc) {
+            IndexPredicate predicate;
+            if (!LibraryIndex::parsePredicate(argv[++i], predicate)) {
+                std::cerr << "Invalid predicate: " << argv[i] << std::endl;
+                return 2;
+            }
+            spec.filter.push_back(predicate);
+            continue;
+        } else if (arg == "--dry-run") {
+            spec.dryRun = true;
+            continue;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            spec.threads = std::strtoul(argv[++i], nullptr, 10);
+            continue;
+        } else if (arg == "--inject-crash" && i + 1 < argc) {
+            spec.crashAfter = std::atoll(argv[++i]);
+            continue;
+        } else if (arg == "--set") {
+            operation = BulkOperation::SET;
+        } else if (arg == "--cap") {
+            operation = BulkOperation::CAP;
+        } else if (arg == "--floor") {
+            operation = BulkOperation::FLOOR;
+        } else if (arg == "--scale") {
+            operation = BulkOperation::SCALE;
+        } else {
+            printUsage();
+            return 2;
+        }
+        BulkAction action;
+        if (i + 1 >= argc || !BulkEdit::parseAction(operation, argv[++i], action)) {
+            std::cerr << "Invalid action: " << arg << (i < argc ? std::string(" ") + argv[i] : "") << std::endl;
+            return 2;
+        }
+        spec.actions.push_back(action);
+    }
+    if (spec.actions.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    BulkEditReport report = BulkEdit::run(spec);
+    if (report.recovered) std::printf("Recovered an interrupted bulk edit from designs/.bulkedit\n");
+    std::printf("Matched %zu of %zu designs (%zu unreadable), %zu changed\n", report.matched, report.scanned,
+                report.unreadable, report.changes.size());
+    if (!report.changes.empty()) {
+        double before[3] = {0, 0, 0}, after[3] = {0, 0, 0};
+        for (const auto& change : report.changes) {
+            before[0] += change.beforeMetrics.speed;
+            before[1] += change.beforeMetrics.fuelConsumption;
+            before[2] += change.beforeMetrics.attributes.cost;
+            after[0] += change.afterMetrics.speed;
+            after[1] += change.afterMetrics.fuelConsumption;
+            after[2] += change.afterMetrics.attributes.cost;
+        }
+        const char* labels[3] = {"Speed (km/h)", "Fuel (L/100km)", "Cost ($)"};
+        double count = static_cast<double>(report.changes.size());
+        std::printf("%-16s %12s %12s %12s\n", "Mean of changed", "Before", "After", "Delta");
+        for (int m = 0; m < 3; ++m) {
+            std::printf("%-16s %12.2f %12.2f %+12.2f\n", labels[m], before[m] / count, after[m] / count,
+                        (after[m] - before[m]) / count);
+        }
+        const size_t shown = std::min<size_t>(report.changes.size(), 10);
+        std::printf("%-32s %10s %10s %12s\n", "Design", "dSpeed", "dFuel", "dCost");
+        for (size_t i = 0; i < shown; ++i) {
+            const BulkEditChange& change = report.changes[i];
+            std::printf("%-32s %+10.2f %+10.2f %+12.2f\n", change.name.c_str(), change.afterMetrics.speed - change.beforeMetrics.speed,
+                        change.afterMetrics.fuelConsumption - change.beforeMetrics.fuelConsumption,
+                        change.afterMetrics.attributes.cost - change.beforeMetrics.attributes.cost);
+        }
+        if (shown < report.changes.size()) std::printf("... and %zu more\n", report.changes.size() - shown);
+    }
+    std::printf("%s in %.2f s\n", report.committed ? "Committed" : "Nothing written", report.seconds);
+    return 0;
+}
+
+int runOptimize(int argc, char** argv) {
+    OptimizerConfig config;
+    size_t topK = 10;
+    std::string savePrefix;
+    bool weightsValid = true;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        const char* value = argv[++i];
+        ObjectiveWeights& w = config.weights;
+        if (arg == "--weights") weightsValid = std::sscanf(value, "%lf,%lf,%lf", &w.speed, &w.fuel, &w.cost) == 3;
+        else if (arg == "--islands") config.islands = std::atoi(value);
+        else if (arg == "--population") config.population = std::atoi(value);
+        else if (arg == "--generations") config.generations = std::atoi(value);
+        else if (arg == "--migration") config.migrationInterval = std::atoi(value);
+        else if (arg == "--seed") config.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--threads") config.threads = std::strtoul(value, nullptr, 10);
+        else if (arg == "--top") topK = std::strtoul(value, nullptr, 10);
+        else if (arg == "--save") savePrefix = value;
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (!weightsValid) {
+        std::cerr << "Weights must be three comma-separated numbers" << std::endl;
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DesignOptimizer optimizer(config);
+    while (!optimizer.finished()) {
+        std::vector<OptimizerProgress> progress = optimizer.advance();
+        const OptimizerProgress& last = progress.back();
+        std::fprintf(stderr, "Generation %d: best %.4f, mean %.4f\n", last.generation, last.bestFitness, last.meanFitness);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<OptimizerCandidate> best = optimizer.best(topK);
+    std::printf("%d islands x %d designs, %d generations in %.2f s\n", config.islands, config.population, config.generations,
+                seconds);
+    std::printf("Top %zu by fitness:\n", best.size());
+    for (const auto& candidate : best) {
+        SweepCandidate row;
+        row.params = candidate.params;
+        row.speed = candidate.metrics.speed;
+        row.fuelConsumption = candidate.metrics.fuelConsumption;
+        row.cost = candidate.metrics.attributes.cost;
+        std::printf("%.4f", candidate.fitness);
+        printCandidate(row);
+    }
+    if (!savePrefix.empty()) {
+        CarDesign design;
+        for (size_t i = 0; i < best.size(); ++i) {
+            design.setParameters(best[i].params);
+            ConfigurationManager::saveDesign(design, savePrefix + std::to_string(i + 1));
+        }
+        std::printf("Saved %s1 to %s%zu\n", savePrefix.c_str(), savePrefix.c_str(), best.size());
+    }
+    return 0;
+}
+
+int runSimilar(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 2;
+    }
+    std::string name = argv[2];
+    size_t k = 10;
+    double withinPercent = -1.0;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--k" && i + 1 < argc) {
+            k = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--within" && i + 1 < argc) {
+            withinPercent = std::strtod(argv[++i], nullptr);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    const DesignParameters* params = index.find(name);
+    if (!params) {
+        std::cerr << "No saved design named " << name << std::endl;
+        return 1;
+    }
+    auto buildStart = std::chrono::steady_clock::now();
+    SimilarityIndex& similarity = index.similarityIndex();
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    auto start = std::chrono::steady_clock::now();
+    auto matches = withinPercent >= 0.0 ? similarity.withinTolerance(*params, withinPercent / 100.0, name)
+                                        : similarity.nearest(*params, k, name);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-32s %10s %10s %10s %12s\n", "Design", "Distance", "Speed", "Fuel", "Cost");
+    for (const auto& match : matches) {
+        std::printf("%-32s %10.4f %10.2f %10.2f %12.2f\n", match.name.c_str(), match.distance, match.speed,
+                    match.fuelConsumption, match.cost);
+    }
+    std::printf("%zu of %zu designs, build %.1f ms, query %.3f ms\n", matches.size(), similarity.size(), buildMs, elapsedMs);
+    return 0;
+}
+
+int runCache(int argc, char** argv) {
+    bool clear = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) == "--clear") {
+            clear = true;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    ResultCache cache;
+    if (!cache.persistent()) {
+        std::cerr << "The result cache file is unavailable or in use by another process" << std::endl;
+        return 1;
+    }
+    if (clear) cache.clear();
+    std::printf("%zu of %zu entries used, model fingerprint %016llx\n", cache.entries(), cache.capacity(),
+                static_cast<unsigned long long>(ResultCache::modelFingerprint()));
+    return 0;
+}
+
+int runScale(int argc, char** argv) {
+    ScalingSpec spec;
+    spec.pinned = CpuTopology::pinning();
+    std::vector<ScalingWorkload> workloads;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--pin") {
+            spec.pinned = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            spec.maxThreads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--designs" && i + 1 < argc) {
+            spec.designs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            spec.seconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--workload" && i + 1 < argc) {
+            ScalingWorkload workload;
+            if (!ScalingBenchmark::parseWorkload(argv[++i], workload)) {
+                std::cerr << "Unknown workload: " << argv[i] << std::endl;
+                return 2;
+            }
+            workloads.push_back(workload);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (!workloads.empty()) spec.workloads = workloads;
+
+    const CpuTopology& topology = CpuTopology::current();
+    std::printf("%zu CPUs on %zu NUMA node%s, workers %s\n", topology.cpuCount(), topology.nodeCount(),
+                topology.nodeCount() == 1 ? "" : "s", spec.pinned ? "pinned with node-local buffers" : "unpinned");
+    std::printf("%-10s %8s %16s %9s %11s %12s\n", "Workload", "Threads", "Items/s", "Speedup", "Efficiency", "GB/s");
+    ScalingBenchmark::run(spec, [](const ScalingPoint& point) {
+        std::printf("%-10s %8zu %16.0f %8.2fx %10.0f%% %12.2f\n", ScalingBenchmark::workloadName(point.workload),
+                    point.threads, point.itemsPerSecond, point.speedup, point.efficiency * 100.0, point.bytesPerSecond / 1e9);
+        std::fflush(stdout);
+    });
+    return 0;
+}
+
+int runReindex() {
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    index.rebuild();
+    std::cout << "Indexed " << index.size() << " designs" << std::endl;
+    return 0;
+}
+
+}
+
+int runHeadlessCommand(int argc, char** argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+    try {
+        if (command == "query") return runQuery(argc, argv);
+        if (command == "similar") return runSimilar(argc, argv);
+        if (command == "reindex") return runReindex();
+        if (command == "sweep") return runSweep(argc, argv);
+        if (command == "cache") return runCache(argc, argv);
+        if (command == "serve") return runServe(argc, argv);
+        if (command == "loadgen") return runLoadGen(argc, argv);
+        if (command == "export") return runExport(argc, argv);
+        if (command == "import") return runImport(argc, argv);
+        if (command == "rank") return runRank(argc, argv);
+        if (command == "telemetry") return runTelemetry(argc, argv);
+        if (command == "scale") return runScale(argc, argv);
+        if (command == "bulkedit") return runBulkEdit(argc, argv);
+        if (command == "optimize") return runOptimize(argc, argv);
+        printUsage();
+        return command == "help" || command == "--help" ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << "An error occurred: " << e.what() << std::endl;
+        return 1;
+    }
+}
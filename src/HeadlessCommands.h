@@ -0,0 +1,9 @@
+#ifndef HEADLESSCOMMANDS_H
+#define HEADLESSCOMMANDS_H
+
+// Command-line modes that run without opening a window, e.g.
+//   F1CarDesigner query --where "cost<60000" --where "fuel<13" --order speed --limit 20
+// Returns the process exit code.
+int runHeadlessCommand(int argc, char** argv);
+
+#endif
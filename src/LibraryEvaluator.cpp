@@ -0,0 +1,339 @@
+#include "LibraryEvaluator.h"
+#include "ConfigurationManager.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const auto DIRECTORY_POLL_INTERVAL = std::chrono::seconds(1);
+const char* CATALOG_PATH = "cache/catalog.f1cache";
+const char* LEGACY_CATALOG_PATH = "designs/catalog.f1cache";
+const char CATALOG_MAGIC[4] = {'F', '1', 'C', 'C'};
+const uint32_t CATALOG_FORMAT = 2;
+const int64_t NO_TIME = INT64_MIN;
+
+bool dominates(const DesignMetrics& a, const DesignMetrics& b) {
+    bool noWorse = a.speed >= b.speed && a.fuelConsumption <= b.fuelConsumption && a.attributes.cost <= b.attributes.cost;
+    bool better = a.speed > b.speed || a.fuelConsumption < b.fuelConsumption || a.attributes.cost < b.attributes.cost;
+    return noWorse && better;
+}
+
+template <typename T>
+void writePod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readPod(const std::string& data, size_t& offset, T& value) {
+    if (data.size() - offset < sizeof(value)) return false;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+}
+
+LibraryEvaluator::~LibraryEvaluator() {
+    stop();
+}
+
+void LibraryEvaluator::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        refreshRequested = false;
+    }
+    worker = std::thread(&LibraryEvaluator::workerLoop, this);
+}
+
+void LibraryEvaluator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+void LibraryEvaluator::requestRefresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        refreshRequested = true;
+    }
+    wake.notify_one();
+}
+
+void LibraryEvaluator::workerLoop() {
+    TraceRecorder::setThreadName("library evaluator");
+    int64_t lastTime = NO_TIME;
+    uint64_t lastFiles = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (restoreCatalog(lastTime, lastFiles)) {
+        rebuildStats();
+        publishCatalog(true, 0, 0, false,
+                       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    } else {
+        lastTime = NO_TIME;
+        lastFiles = 0;
+    }
+
+    bool firstPass = true;
+    while (true) {
+        bool refresh;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!firstPass) {
+                wake.wait_for(lock, DIRECTORY_POLL_INTERVAL, [this]() { return stopping || refreshRequested; });
+            }
+            if (stopping) return;
+            refresh = refreshRequested;
+            refreshRequested = false;
+        }
+        // Overwriting a design in place leaves the directory timestamp
+        // alone, which is why saves also request a refresh explicitly.
+        int64_t time = ConfigurationManager::designsDirectoryTime();
+        bool unchanged = time == lastTime && (time != NO_TIME || !firstPass);
+        firstPass = false;
+        if (!refresh && unchanged) continue;
+        lastTime = time;
+        // The index and the histories move the timestamp too; only a change
+        // to the design files themselves is worth a scan.
+        uint64_t files = ConfigurationManager::designFilesStamp();
+        if (!refresh && files != 0 && files == lastFiles) continue;
+        lastFiles = files;
+        start = std::chrono::steady_clock::now();
+        int reloaded = 0, skipped = 0;
+        bool directoryError = false;
+        bool changed = reconcile(reloaded, skipped, directoryError);
+        if (changed && !directoryError) {
+            try {
+                persistCatalog(time, files);
+            } catch (const std::exception& e) {
+                // Log error but don't throw; the next start simply rescans
+            }
+        }
+        publishCatalog(false, reloaded, skipped, directoryError,
+                       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+bool LibraryEvaluator::reconcile(int& reloaded, int& skipped, bool& directoryError) {
+    TRACE_ZONE("LibraryEvaluator::reconcile");
+    ConfigurationManager::ensureDesignsDirectory();
+    struct FileInfo {
+        std::string name;
+        int64_t modified;
+        uint64_t size;
+    };
+    std::vector<FileInfo> files;
+    std::error_code error;
+    for (fs::directory_iterator it("designs", error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != ".f1design") continue;
+        std::error_code statError;
+        auto modified = it->last_write_time(statError);
+        auto size = statError ? 0 : it->file_size(statError);
+        if (statError) {
+            ++skipped;
+            continue;
+        }
+        files.push_back({it->path().stem().string(), static_cast<int64_t>(modified.time_since_epoch().count()), size});
+    }
+    directoryError = static_cast<bool>(error);
+    if (directoryError) return false;
+    std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) { return a.name < b.name; });
+
+    std::unordered_map<std::string, size_t> previous;
+    previous.reserve(catalog.size());
+    for (size_t i = 0; i < catalog.size(); ++i) previous.emplace(catalog[i].name, i);
+
+    std::vector<CatalogEntry> updated;
+    updated.reserve(files.size());
+    // Old entries not carried over or replaced below have left the library.
+    std::vector<bool> carried(catalog.size(), false);
+    std::unordered_map<std::string, std::pair<int64_t, uint64_t>> stillUnreadable;
+    // The previous scan's design is gone, so its arena memory can be reused.
+    arena.release();
+    CarDesign design(arena.resource());
+    for (auto& file : files) {
+        auto it = previous.find(file.name);
+        if (it != previous.end() && catalog[it->second].modified == file.modified && catalog[it->second].size == file.size) {
+            carried[it->second] = true;
+            updated.push_back(std::move(catalog[it->second]));
+            continue;
+        }
+        auto stamp = std::make_pair(file.modified, file.size);
+        auto bad = unreadable.find(file.name);
+        if (bad == unreadable.end() || bad->second != stamp) {
+            try {
+                {
+                    DesignArena::HeapWatch watch(arena);
+                    design.loadFromFile(file.name);
+                }
+                ++reloaded;
+                if (it != previous.end()) {
+                    carried[it->second] = true;
+                    stats.remove(catalog[it->second].params);
+                    ++statsUpdates;
+                }
+                stats.add(design.getParameters());
+                ++statsUpdates;
+                updated.push_back({std::move(file.name), file.modified, file.size, design.getParameters()});
+                continue;
+            } catch (const std::exception& e) {
+                // Skip corrupted files
+            }
+        }
+        ++skipped;
+        stillUnreadable.emplace(std::move(file.name), stamp);
+    }
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        if (carried[i]) continue;
+        stats.remove(catalog[i].params);
+        ++statsUpdates;
+    }
+    // Every kept entry came from the old catalog, so equal sizes without
+    // reloads mean the same set of designs.
+    bool changed = reloaded > 0 || updated.size() != catalog.size();
+    catalog = std::move(updated);
+    unreadable = std::move(stillUnreadable);
+    // Removals slowly lose floating-point precision in the running moments;
+    // rebuilding once updates outnumber designs keeps the cost amortized O(1).
+    if (statsUpdates > std::max<size_t>(catalog.size(), 1024)) rebuildStats();
+    return changed;
+}
+
+void LibraryEvaluator::rebuildStats() {
+    TRACE_ZONE("LibraryEvaluator::rebuildStats");
+    std::vector<DesignParameters> designs;
+    designs.reserve(catalog.size());
+    for (const auto& entry : catalog) designs.push_back(entry.params);
+    stats = LibraryStats::compute(designs);
+    statsUpdates = 0;
+}
+
+void LibraryEvaluator::publishCatalog(bool fromCache, int reloaded, int skipped, bool directoryError, double millis) {
+    TRACE_ZONE("LibraryEvaluator::publishCatalog");
+    LibrarySnapshot& snapshot = channel.writeBuffer();
+    // Clearing keeps the slot's capacity, so steady-state rescans do not allocate.
+    snapshot.names.resize(catalog.size());
+    snapshot.params.clear();
+    snapshot.metrics.clear();
+    snapshot.pareto.clear();
+    snapshot.fastest = snapshot.mostEfficient = snapshot.cheapest = -1;
+    snapshot.allocations = arena.stats();
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        snapshot.names[i].assign(catalog[i].name);
+        snapshot.params.push_back(catalog[i].params);
+        snapshot.metrics.push_back(CarDesign::evaluate(catalog[i].params));
+    }
+
+    const auto& metrics = snapshot.metrics;
+    for (uint32_t i = 0; i < metrics.size(); ++i) {
+        if (snapshot.fastest < 0 || metrics[i].speed > metrics[snapshot.fastest].speed) snapshot.fastest = i;
+        if (snapshot.mostEfficient < 0 || metrics[i].fuelConsumption < metrics[snapshot.mostEfficient].fuelConsumption) snapshot.mostEfficient = i;
+        if (snapshot.cheapest < 0 || metrics[i].attributes.cost < metrics[snapshot.cheapest].attributes.cost) snapshot.cheapest = i;
+
+        bool dominated = false;
+        for (uint32_t member : snapshot.pareto) {
+            if (dominates(metrics[member], metrics[i])) {
+                dominated = true;
+                break;
+            }
+        }
+        if (dominated) continue;
+        snapshot.pareto.erase(std::remove_if(snapshot.pareto.begin(), snapshot.pareto.end(),
+                                             [&](uint32_t member) { return dominates(metrics[i], metrics[member]); }),
+                              snapshot.pareto.end());
+        snapshot.pareto.push_back(i);
+    }
+    std::sort(snapshot.pareto.begin(), snapshot.pareto.end(),
+              [&](uint32_t a, uint32_t b) { return metrics[a].speed > metrics[b].speed; });
+
+    snapshot.stats = stats;
+    for (int m = 0; m < STAT_METRIC_COUNT; ++m) snapshot.summaries[m] = stats.summarize(static_cast<StatMetric>(m));
+
+    snapshot.skippedFiles = skipped;
+    snapshot.reloadedFiles = reloaded;
+    snapshot.directoryError = directoryError;
+    snapshot.fromCache = fromCache;
+    snapshot.generation = ++generation;
+    snapshot.scanMillis = millis;
+    channel.publish();
+}
+
+// Layout (native byte order): "F1CC" | uint32 format | int64 directory time |
+// uint64 design files stamp | uint32 count | count x (uint16 name length | name | int64 mtime | uint64 size |
+// uint8 parts[4] | double aero[4]) | uint32 count again as a completeness check.
+bool LibraryEvaluator::restoreCatalog(int64_t& time, uint64_t& files) {
+    std::ifstream file(CATALOG_PATH, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    char magic[4];
+    uint32_t format = 0, count = 0, trailer = 0;
+    if (data.size() < sizeof(magic)) return false;
+    std::memcpy(magic, data.data(), sizeof(magic));
+    offset = sizeof(magic);
+    if (std::memcmp(magic, CATALOG_MAGIC, sizeof(magic)) != 0 || !readPod(data, offset, format) ||
+        format != CATALOG_FORMAT || !readPod(data, offset, time) || !readPod(data, offset, files) ||
+        !readPod(data, offset, count)) {
+        return false;
+    }
+    std::vector<CatalogEntry> entries;
+    entries.reserve(std::min<size_t>(count, data.size() / 64));
+    for (uint32_t i = 0; i < count; ++i) {
+        CatalogEntry entry;
+        uint16_t nameLength = 0;
+        uint8_t parts[4];
+        if (!readPod(data, offset, nameLength) || data.size() - offset < nameLength) return false;
+        entry.name.assign(data, offset, nameLength);
+        offset += nameLength;
+        if (!readPod(data, offset, entry.modified) || !readPod(data, offset, entry.size) ||
+            !readPod(data, offset, parts) || !readPod(data, offset, entry.params.aero)) {
+            return false;
+        }
+        for (int p = 0; p < 4; ++p) entry.params.parts[p] = parts[p];
+        entries.push_back(std::move(entry));
+    }
+    if (!readPod(data, offset, trailer) || trailer != count) return false;
+    catalog = std::move(entries);
+    return true;
+}
+
+void LibraryEvaluator::persistCatalog(int64_t time, uint64_t files) {
+    std::string data(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    writePod(data, CATALOG_FORMAT);
+    writePod(data, time);
+    writePod(data, files);
+    writePod(data, static_cast<uint32_t>(catalog.size()));
+    for (const auto& entry : catalog) {
+        writePod(data, static_cast<uint16_t>(entry.name.size()));
+        data.append(entry.name);
+        writePod(data, entry.modified);
+        writePod(data, entry.size);
+        for (int p = 0; p < 4; ++p) data.push_back(static_cast<char>(entry.params.parts[p]));
+        writePod(data, entry.params.aero);
+    }
+    writePod(data, static_cast<uint32_t>(catalog.size()));
+
+    std::error_code error;
+    fs::create_directories(fs::path(CATALOG_PATH).parent_path(), error);
+    std::string tempPath = std::string(CATALOG_PATH) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Failed to write design catalog");
+        file.write(data.data(), data.size());
+        if (!file) throw std::runtime_error("Failed to write design catalog");
+    }
+    fs::rename(tempPath, CATALOG_PATH);
+    // Earlier versions kept the catalog next to the designs.
+    fs::remove(LEGACY_CATALOG_PATH, error);
+}
@@ -0,0 +1,94 @@
+#ifndef LIBRARYEVALUATOR_H
+#define LIBRARYEVALUATOR_H
+
+#include "CarDesign.h"
+#include "DesignArena.h"
+#include "LibraryStats.h"
+#include "SnapshotChannel.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Everything the UI shows about the saved library, evaluated off the render thread.
+struct LibrarySnapshot {
+    uint64_t generation{0};  // 0 until the catalog is restored or first scanned
+    std::vector<std::string> names;
+    std::vector<DesignParameters> params;
+    std::vector<DesignMetrics> metrics;
+    std::vector<uint32_t> pareto;  // indices on the speed/fuel/cost front
+    int fastest{-1};
+    int mostEfficient{-1};
+    int cheapest{-1};
+    LibraryStats stats;            // maintained incrementally by the worker
+    MetricSummary summaries[STAT_METRIC_COUNT];
+    int skippedFiles{0};           // unreadable or corrupted design files
+    bool directoryError{false};
+    bool fromCache{false};         // restored from the persisted catalog, not yet reconciled
+    int reloadedFiles{0};          // design files parsed by the last scan
+    double scanMillis{0.0};
+    AllocationStats allocations;   // made while parsing design files, since start
+};
+
+// Background worker that loads and evaluates every saved design and
+// publishes the result through a SnapshotChannel. It rescans when asked to
+// and whenever the designs directory changes on disk.
+//
+// The catalog (names, file stamps and parameters) persists in
+// cache/catalog.f1cache, outside the directory it describes. At start the
+// worker publishes it straight away and only reconciles with the directory
+// when the design files changed (ConfigurationManager::designFilesStamp),
+// which it checks only once the directory timestamp moved.
+// Scans stat every file but parse only those whose size or mtime changed.
+// Library statistics follow the same way: a scan adds and removes only the
+// designs that changed, so publishing them costs the same at any size.
+class LibraryEvaluator {
+public:
+    LibraryEvaluator() = default;
+    ~LibraryEvaluator();
+    LibraryEvaluator(const LibraryEvaluator&) = delete;
+    LibraryEvaluator& operator=(const LibraryEvaluator&) = delete;
+
+    void start();
+    void stop();
+    void requestRefresh();
+
+    // UI thread only; wait-free.
+    const LibrarySnapshot& latest() { return channel.read(); }
+
+private:
+    struct CatalogEntry {
+        std::string name;
+        int64_t modified{0};
+        uint64_t size{0};
+        DesignParameters params;
+    };
+
+    void workerLoop();
+    // Brings the catalog in line with the directory; returns true if anything changed.
+    bool reconcile(int& reloaded, int& skipped, bool& directoryError);
+    void publishCatalog(bool fromCache, int reloaded, int skipped, bool directoryError, double millis);
+    void rebuildStats();
+    bool restoreCatalog(int64_t& directoryTime, uint64_t& filesStamp);
+    void persistCatalog(int64_t directoryTime, uint64_t filesStamp);
+
+    SnapshotChannel<LibrarySnapshot> channel;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool refreshRequested{true};
+    bool stopping{false};
+    uint64_t generation{0};
+    std::vector<CatalogEntry> catalog;  // worker only, sorted by name
+    LibraryStats stats;                 // worker only, always matches catalog
+    DesignArena arena;                  // worker only, backs the design each scan parses into
+    size_t statsUpdates{0};             // incremental updates since the last rebuild
+    // Files that failed to parse, by stamp, so they are not retried until they change.
+    std::unordered_map<std::string, std::pair<int64_t, uint64_t>> unreadable;
+};
+
+#endif
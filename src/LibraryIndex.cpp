@@ -0,0 +1,430 @@
+#include "LibraryIndex.h"
+#include "ConfigurationManager.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBRARYINDEX_SSE2 1
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'F', '1', 'I', 'X'};
+const uint32_t INDEX_FORMAT = 3;
+const size_t STAMP_OFFSET = sizeof(INDEX_MAGIC) + sizeof(INDEX_FORMAT);
+const size_t HEADER_SIZE = STAMP_OFFSET + sizeof(int64_t) + sizeof(uint64_t);
+const int64_t NO_TIME = INT64_MIN;
+const uint64_t NO_STAMP = 0;
+const uint8_t OP_UPSERT = 1;
+const uint8_t OP_REMOVE = 2;
+const int COLUMN_COUNT = static_cast<int>(IndexColumn::COUNT);
+
+// Header layout: magic | uint32 format | int64 designs directory time |
+// uint64 design files stamp (see ConfigurationManager::designFilesStamp).
+void writeHeader(std::string& out) {
+    out.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    out.append(reinterpret_cast<const char*>(&INDEX_FORMAT), sizeof(INDEX_FORMAT));
+    out.append(reinterpret_cast<const char*>(&NO_TIME), sizeof(NO_TIME));
+    out.append(reinterpret_cast<const char*>(&NO_STAMP), sizeof(NO_STAMP));
+}
+
+// Record layout (native byte order):
+//   uint8 op | uint8 name length | name | upserts only: uint8 parts[4] | double aero[4]
+void writeRecord(std::string& out, uint8_t op, const std::string& name, const DesignParameters* params) {
+    out.push_back(static_cast<char>(op));
+    out.push_back(static_cast<char>(name.size()));
+    out.append(name);
+    if (params) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>(params->parts[i]));
+        out.append(reinterpret_cast<const char*>(params->aero), sizeof(params->aero));
+    }
+}
+
+}
+
+LibraryIndex::LibraryIndex(const std::string& path) : path(path) {}
+
+const char* LibraryIndex::columnName(IndexColumn column) {
+    static const char* names[COLUMN_COUNT] = {
+        "FrontWing", "RearWing", "Diffuser", "Sidepods",
+        "FrontWingAero", "RearWingAero", "DiffuserAero", "SidepodsAero",
+        "Drag", "Mass", "Cost", "Speed", "Fuel"};
+    int index = static_cast<int>(column);
+    return index >= 0 && index < COLUMN_COUNT ? names[index] : "";
+}
+
+bool LibraryIndex::parseColumn(const std::string& text, IndexColumn& column) {
+    for (int i = 0; i < COLUMN_COUNT; ++i) {
+        const char* name = columnName(static_cast<IndexColumn>(i));
+        if (text.size() == std::strlen(name) &&
+            std::equal(text.begin(), text.end(), name, [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+            })) {
+            column = static_cast<IndexColumn>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LibraryIndex::parsePredicate(const std::string& text, IndexPredicate& predicate) {
+    size_t opStart = text.find_first_of("<>=");
+    if (opStart == std::string::npos || opStart == 0) return false;
+    size_t opEnd = text.find_first_not_of("<>=", opStart);
+    if (opEnd == std::string::npos) return false;
+    std::string name = text.substr(0, opStart);
+    name.erase(std::remove_if(name.begin(), name.end(), [](unsigned char c) { return std::isspace(c); }), name.end());
+    std::string op = text.substr(opStart, opEnd - opStart);
+    const char* valueText = text.c_str() + opEnd;
+    char* end = nullptr;
+    float value = std::strtof(valueText, &end);
+    if (end == valueText || !parseColumn(name, predicate.column)) return false;
+    while (*end && std::isspace(static_cast<unsigned char>(*end))) ++end;
+    if (*end) return false;
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    predicate.min = -infinity;
+    predicate.max = infinity;
+    if (op == "<") predicate.max = std::nextafter(value, -infinity);
+    else if (op == "<=") predicate.max = value;
+    else if (op == ">") predicate.min = std::nextafter(value, infinity);
+    else if (op == ">=") predicate.min = value;
+    else if (op == "=" || op == "==") predicate.min = predicate.max = value;
+    else return false;
+    return true;
+}
+
+void LibraryIndex::rowValues(const DesignParameters& design, float* values) {
+    DesignMetrics metrics = CarDesign::evaluate(design);
+    for (int i = 0; i < 4; ++i) {
+        values[i] = static_cast<float>(design.parts[i]);
+        values[4 + i] = static_cast<float>(design.aero[i]);
+    }
+    values[static_cast<int>(IndexColumn::DRAG)] = static_cast<float>(metrics.attributes.drag);
+    values[static_cast<int>(IndexColumn::MASS)] = static_cast<float>(metrics.attributes.mass);
+    values[static_cast<int>(IndexColumn::COST)] = static_cast<float>(metrics.attributes.cost);
+    values[static_cast<int>(IndexColumn::SPEED)] = static_cast<float>(metrics.speed);
+    values[static_cast<int>(IndexColumn::FUEL)] = static_cast<float>(metrics.fuelConsumption);
+}
+
+bool LibraryIndex::matches(const std::vector<IndexPredicate>& predicates, const DesignParameters& design) {
+    float values[COLUMN_COUNT];
+    rowValues(design, values);
+    for (const auto& predicate : predicates) {
+        float value = values[static_cast<int>(predicate.column)];
+        if (!(value >= predicate.min && value <= predicate.max)) return false;
+    }
+    return true;
+}
+
+void LibraryIndex::setRow(uint32_t row, const DesignParameters& design) {
+    float values[COLUMN_COUNT];
+    rowValues(design, values);
+    for (int i = 0; i < COLUMN_COUNT; ++i) columns[i][row] = values[i];
+    params[row] = design;
+}
+
+void LibraryIndex::applyUpsert(const std::string& name, const DesignParameters& design) {
+    auto it = rows.find(name);
+    uint32_t row;
+    if (it != rows.end()) {
+        row = it->second;
+    } else {
+        row = static_cast<uint32_t>(names.size());
+        for (auto& column : columns) column.push_back(0.0f);
+        names.push_back(name);
+        params.emplace_back();
+        rows.emplace(name, row);
+    }
+    setRow(row, design);
+    if (similarityBuilt) similarity.upsert(name, design);
+}
+
+void LibraryIndex::applyRemove(const std::string& name) {
+    auto it = rows.find(name);
+    if (it == rows.end()) return;
+    uint32_t row = it->second;
+    uint32_t last = static_cast<uint32_t>(names.size() - 1);
+    rows.erase(it);
+    if (row != last) {
+        for (auto& column : columns) column[row] = column[last];
+        names[row] = std::move(names[last]);
+        params[row] = params[last];
+        rows[names[row]] = row;
+    }
+    for (auto& column : columns) column.pop_back();
+    names.pop_back();
+    params.pop_back();
+    if (similarityBuilt) similarity.remove(name);
+}
+
+void LibraryIndex::open() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        rebuild();
+        return;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    for (auto& column : columns) column.clear();
+    names.clear();
+    params.clear();
+    rows.clear();
+    similarityBuilt = false;
+    logRecords = 0;
+    uint32_t format = 0;
+    int64_t time = NO_TIME;
+    uint64_t stamp = NO_STAMP;
+    // Read before listing, so a design added meanwhile still moves it on.
+    int64_t directoryTime = ConfigurationManager::designsDirectoryTime();
+    bool refreshTime = false;
+    bool valid = data.size() >= HEADER_SIZE && std::memcmp(data.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+    if (valid) {
+        std::memcpy(&format, data.data() + sizeof(INDEX_MAGIC), sizeof(format));
+        std::memcpy(&time, data.data() + STAMP_OFFSET, sizeof(time));
+        std::memcpy(&stamp, data.data() + STAMP_OFFSET + sizeof(time), sizeof(stamp));
+        valid = format == INDEX_FORMAT && stamp != NO_STAMP;
+        // An unchanged directory time vouches for the design files without
+        // listing them. Caches and histories written next to them move it too,
+        // so only a changed set of design files invalidates the index.
+        if (valid && (time == NO_TIME || time != directoryTime)) {
+            valid = stamp == ConfigurationManager::designFilesStamp();
+            refreshTime = valid;
+        }
+    }
+    size_t offset = HEADER_SIZE;
+    while (valid && offset < data.size()) {
+        if (offset + 2 > data.size()) { valid = false; break; }
+        uint8_t op = static_cast<uint8_t>(data[offset]);
+        size_t nameLength = static_cast<uint8_t>(data[offset + 1]);
+        size_t payload = op == OP_UPSERT ? 4 + 4 * sizeof(double) : 0;
+        if ((op != OP_UPSERT && op != OP_REMOVE) || offset + 2 + nameLength + payload > data.size()) {
+            valid = false;
+            break;
+        }
+        std::string name = data.substr(offset + 2, nameLength);
+        offset += 2 + nameLength;
+        if (op == OP_UPSERT) {
+            DesignParameters design;
+            for (int i = 0; i < 4; ++i) design.parts[i] = static_cast<uint8_t>(data[offset + i]);
+            std::memcpy(design.aero, data.data() + offset + 4, sizeof(design.aero));
+            offset += payload;
+            try {
+                applyUpsert(name, design);
+            } catch (const std::exception& e) {
+                valid = false;
+            }
+        } else {
+            applyRemove(name);
+        }
+        ++logRecords;
+    }
+    fileHasHeader = valid;
+    stale = false;
+    if (!valid) {
+        rebuild();
+    } else if (refreshTime) {
+        // The files stamp was just checked; only the directory time is new.
+        std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(STAMP_OFFSET);
+        out.write(reinterpret_cast<const char*>(&directoryTime), sizeof(directoryTime));
+    }
+}
+
+void LibraryIndex::rebuild() {
+    for (auto& column : columns) column.clear();
+    names.clear();
+    params.clear();
+    rows.clear();
+    similarityBuilt = false;
+    stale = false;
+    CarDesign design;
+    for (const auto& file : ConfigurationManager::getDesignFiles()) {
+        try {
+            design.loadFromFile(file);
+            applyUpsert(file, design.getParameters());
+        } catch (const std::exception& e) {
+            // Skip corrupted files
+        }
+    }
+    compact();
+}
+
+const DesignParameters* LibraryIndex::find(const std::string& name) const {
+    auto it = rows.find(name);
+    return it != rows.end() ? &params[it->second] : nullptr;
+}
+
+SimilarityIndex& LibraryIndex::similarityIndex() {
+    if (!similarityBuilt) {
+        similarity.build(names, params);
+        similarityBuilt = true;
+    }
+    return similarity;
+}
+
+void LibraryIndex::compact() {
+    std::string data;
+    writeHeader(data);
+    for (size_t row = 0; row < names.size(); ++row) writeRecord(data, OP_UPSERT, names[row], &params[row]);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Failed to write library index");
+        file.write(data.data(), data.size());
+        if (!file) throw std::runtime_error("Failed to write library index");
+    }
+    fs::rename(tempPath, path);
+    fileHasHeader = true;
+    logRecords = names.size();
+    // The rename moved the directory time, so it can only be recorded now.
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    writeStamp(file);
+}
+
+void LibraryIndex::writeStamp(std::fstream& file) {
+    int64_t time = stale ? NO_TIME : ConfigurationManager::designsDirectoryTime();
+    uint64_t stamp = stale ? NO_STAMP : ConfigurationManager::designFilesStamp();
+    file.seekp(STAMP_OFFSET);
+    file.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    file.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+}
+
+void LibraryIndex::invalidate() {
+    stale = true;
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (file.is_open()) writeStamp(file);
+    if (!file.is_open() || !file) {
+        std::error_code ignored;
+        fs::remove(path, ignored);
+    }
+}
+
+void LibraryIndex::appendRecord(uint8_t op, const std::string& name, const DesignParameters* design) {
+    std::string data;
+    writeRecord(data, op, name, design);
+    appendRecords(data, 1);
+}
+
+void LibraryIndex::appendRecords(const std::string& data, size_t records) {
+    if (!fileHasHeader || logRecords + records > 2 * names.size() + 1024) {
+        compact();
+        return;
+    }
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) throw std::runtime_error("Failed to write library index");
+    file.seekp(0, std::ios::end);
+    file.write(data.data(), data.size());
+    // The caller has just changed the design files, so the index now matches them.
+    writeStamp(file);
+    if (!file) throw std::runtime_error("Failed to write library index");
+    logRecords += records;
+}
+
+void LibraryIndex::upsert(const std::string& name, const DesignParameters& design) {
+    if (name.size() > 255) throw std::invalid_argument("Design name too long for library index");
+    applyUpsert(name, design);
+    appendRecord(OP_UPSERT, name, &design);
+}
+
+void LibraryIndex::upsert(const std::vector<std::pair<std::string, DesignParameters>>& designs) {
+    for (const auto& design : designs) {
+        if (design.first.size() > 255) throw std::invalid_argument("Design name too long for library index");
+    }
+    if (designs.empty()) return;
+    std::string data;
+    for (const auto& [name, design] : designs) {
+        applyUpsert(name, design);
+        writeRecord(data, OP_UPSERT, name, &design);
+    }
+    appendRecords(data, designs.size());
+}
+
+void LibraryIndex::remove(const std::string& name) {
+    if (!contains(name)) return;
+    applyRemove(name);
+    appendRecord(OP_REMOVE, name, nullptr);
+}
+
+std::vector<IndexRow> LibraryIndex::query(const IndexQuery& q) const {
+    const size_t count = names.size();
+    if (q.limit == 0 || count == 0) return {};
+
+    // Heap ordered so that its front is the worst of the kept rows.
+    using Entry = std::pair<float, uint32_t>;
+    const bool descending = q.descending;
+    auto better = [descending](const Entry& a, const Entry& b) {
+        if (a.first != b.first) return descending ? a.first > b.first : a.first < b.first;
+        return a.second < b.second;
+    };
+    std::vector<Entry> heap;
+    heap.reserve(std::min(q.limit, count) + 1);
+    const float* order = columns[static_cast<int>(q.orderBy)].data();
+    auto offer = [&](uint32_t row) {
+        Entry entry{order[row], row};
+        if (std::isnan(entry.first)) return;
+        if (heap.size() < q.limit) {
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(entry, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = entry;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    };
+
+    size_t row = 0;
+#ifdef LIBRARYINDEX_SSE2
+    struct Bounds {
+        const float* data;
+        __m128 min;
+        __m128 max;
+    };
+    std::vector<Bounds> bounds;
+    for (const auto& predicate : q.predicates) {
+        bounds.push_back({columns[static_cast<int>(predicate.column)].data(),
+                          _mm_set1_ps(predicate.min), _mm_set1_ps(predicate.max)});
+    }
+    const __m128 allPass = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (; row + 4 <= count; row += 4) {
+        __m128 pass = allPass;
+        for (const auto& b : bounds) {
+            __m128 value = _mm_loadu_ps(b.data + row);
+            pass = _mm_and_ps(pass, _mm_and_ps(_mm_cmpge_ps(value, b.min), _mm_cmple_ps(value, b.max)));
+        }
+        int mask = _mm_movemask_ps(pass);
+        for (int bit = 0; mask != 0; ++bit, mask >>= 1) {
+            if (mask & 1) offer(static_cast<uint32_t>(row + bit));
+        }
+    }
+#endif
+    for (; row < count; ++row) {
+        bool pass = true;
+        for (const auto& predicate : q.predicates) {
+            float value = columns[static_cast<int>(predicate.column)][row];
+            pass = pass && value >= predicate.min && value <= predicate.max;
+        }
+        if (pass) offer(static_cast<uint32_t>(row));
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), better);
+    std::vector<IndexRow> results(heap.size());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        uint32_t hit = heap[i].second;
+        results[i].name = names[hit];
+        for (int c = 0; c < COLUMN_COUNT; ++c) results[i].values[c] = columns[c][hit];
+    }
+    return results;
+}
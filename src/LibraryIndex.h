@@ -0,0 +1,111 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include "CarDesign.h"
+#include "SimilarityIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class IndexColumn {
+    FRONT_WING, REAR_WING, DIFFUSER, SIDEPODS,
+    FRONT_WING_AERO, REAR_WING_AERO, DIFFUSER_AERO, SIDEPODS_AERO,
+    DRAG, MASS, COST, SPEED, FUEL,
+    COUNT
+};
+
+// Inclusive range filter on one column.
+struct IndexPredicate {
+    IndexColumn column;
+    float min;
+    float max;
+};
+
+struct IndexQuery {
+    std::vector<IndexPredicate> predicates;
+    IndexColumn orderBy{IndexColumn::SPEED};
+    bool descending{true};
+    size_t limit{20};
+};
+
+struct IndexRow {
+    std::string name;
+    float values[static_cast<int>(IndexColumn::COUNT)];
+    float get(IndexColumn column) const { return values[static_cast<int>(column)]; }
+};
+
+// Columnar index over the saved library (designs/library.f1index).
+//
+// Every design is one row of float columns: part indices, aero factors and
+// the derived drag, mass, cost, speed and fuel. Queries scan the predicate
+// columns four rows at a time with SSE2 (scalar elsewhere) and keep the best
+// rows in a bounded heap. The file is an append-only log of upserts and
+// removals, replayed on open and compacted once stale records dominate.
+// The header records a stamp of the .f1design files (names and
+// modification times) as of the last write, and open() rebuilds the index
+// when they have changed since, so designs added, deleted or replaced
+// behind its back are picked up. Other files in designs/ are ignored. The
+// directory's modification time is kept as well and the files are only
+// listed once it has moved, so a design overwritten in place by another
+// program goes unnoticed until then; use rebuild() after editing by hand.
+// Not thread-safe.
+class LibraryIndex {
+public:
+    explicit LibraryIndex(const std::string& path = "designs/library.f1index");
+
+    // Loads the index file, rebuilding it from the designs directory if
+    // missing, unreadable or out of date with the design files.
+    void open();
+    void rebuild();
+    void upsert(const std::string& name, const DesignParameters& params);
+    // upsert() for every design, with a single write to the file.
+    void upsert(const std::vector<std::pair<std::string, DesignParameters>>& designs);
+    void remove(const std::string& name);
+    // Marks the file out of date, so the next open() rebuilds it. For callers
+    // whose upsert() or remove() failed after the design file had changed.
+    void invalidate();
+
+    std::vector<IndexRow> query(const IndexQuery& query) const;
+    size_t size() const { return names.size(); }
+    bool contains(const std::string& name) const { return rows.count(name) != 0; }
+    // Parameters of a saved design, or nullptr if it is not in the index.
+    const DesignParameters* find(const std::string& name) const;
+    // Nearest-neighbour index over the same rows, built on first use and
+    // kept current by upsert() and remove() from then on.
+    SimilarityIndex& similarityIndex();
+
+    static const char* columnName(IndexColumn column);
+    // Fills one value per IndexColumn for design, as stored in its row.
+    static void rowValues(const DesignParameters& design, float* values);
+    // Whether design satisfies every predicate, with the same comparisons as query().
+    static bool matches(const std::vector<IndexPredicate>& predicates, const DesignParameters& design);
+    // Parses "cost<60000", "fuel<=13", "speed>300" or "rearwing=2".
+    static bool parsePredicate(const std::string& text, IndexPredicate& predicate);
+    static bool parseColumn(const std::string& text, IndexColumn& column);
+
+private:
+    void setRow(uint32_t row, const DesignParameters& params);
+    void applyUpsert(const std::string& name, const DesignParameters& params);
+    void applyRemove(const std::string& name);
+    void appendRecord(uint8_t op, const std::string& name, const DesignParameters* params);
+    void appendRecords(const std::string& data, size_t records);
+    void compact();
+    void writeStamp(std::fstream& file);
+
+    std::string path;
+    std::vector<float> columns[static_cast<int>(IndexColumn::COUNT)];
+    std::vector<std::string> names;
+    std::vector<DesignParameters> params;
+    std::unordered_map<std::string, uint32_t> rows;
+    size_t logRecords{0};
+    bool fileHasHeader{false};
+    SimilarityIndex similarity;
+    bool similarityBuilt{false};
+    bool stale{false};  // a change was not recorded; keeps the stamp invalid until rebuilt
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "LibraryStats.h"
+#include "TaskRuntime.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+const size_t COMPUTE_CHUNK = 4096;
+
+struct MetricRange {
+    double min[STAT_METRIC_COUNT];
+    double max[STAT_METRIC_COUNT];
+};
+
+// Smallest and largest value each metric can take, from the part catalogs
+// with every aero factor in [0.5, 1.5].
+const MetricRange& metricRange() {
+    static const MetricRange range = []() {
+        PartAttributes (*const catalogs[4])(int) = {FrontWing::getDesignAttributes, RearWing::getDesignAttributes,
+                                                    Diffuser::getDesignAttributes, Sidepods::getDesignAttributes};
+        const int counts[4] = {FrontWing::getDesignCount(), RearWing::getDesignCount(), Diffuser::getDesignCount(),
+                               Sidepods::getDesignCount()};
+        PartAttributes low, high;
+        for (int part = 0; part < 4; ++part) {
+            PartAttributes partLow = catalogs[part](0), partHigh = partLow;
+            for (int index = 1; index < counts[part]; ++index) {
+                PartAttributes attributes = catalogs[part](index);
+                partLow = {std::min(partLow.drag, attributes.drag), std::min(partLow.mass, attributes.mass),
+                           std::min(partLow.cost, attributes.cost)};
+                partHigh = {std::max(partHigh.drag, attributes.drag), std::max(partHigh.mass, attributes.mass),
+                            std::max(partHigh.cost, attributes.cost)};
+            }
+            low = low + partLow * 0.5;
+            high = high + partHigh * 1.5;
+        }
+        // Speed falls and fuel rises with both drag and mass.
+        DesignMetrics best = CarDesign::evaluate(low), worst = CarDesign::evaluate(high);
+        MetricRange result;
+        result.min[static_cast<int>(StatMetric::SPEED)] = worst.speed;
+        result.max[static_cast<int>(StatMetric::SPEED)] = best.speed;
+        result.min[static_cast<int>(StatMetric::FUEL)] = best.fuelConsumption;
+        result.max[static_cast<int>(StatMetric::FUEL)] = worst.fuelConsumption;
+        result.min[static_cast<int>(StatMetric::COST)] = low.cost;
+        result.max[static_cast<int>(StatMetric::COST)] = high.cost;
+        result.min[static_cast<int>(StatMetric::MASS)] = low.mass;
+        result.max[static_cast<int>(StatMetric::MASS)] = high.mass;
+        return result;
+    }();
+    return range;
+}
+
+}
+
+void MomentSketch::add(double value) {
+    ++count;
+    double delta = value - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+}
+
+void MomentSketch::remove(double value) {
+    if (count <= 1) {
+        *this = MomentSketch();
+        return;
+    }
+    --count;
+    double delta = value - mean;
+    mean -= delta / static_cast<double>(count);
+    m2 = std::max(m2 - delta * (value - mean), 0.0);
+}
+
+void MomentSketch::merge(const MomentSketch& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    double total = static_cast<double>(count + other.count);
+    double delta = other.mean - mean;
+    mean += delta * static_cast<double>(other.count) / total;
+    m2 += other.m2 + delta * delta * static_cast<double>(count) * static_cast<double>(other.count) / total;
+    count += other.count;
+}
+
+int QuantileSketch::bin(double value) const {
+    double position = (value - min) / (max - min) * BINS;
+    return std::clamp(static_cast<int>(position), 0, BINS - 1);
+}
+
+void QuantileSketch::remove(double value) {
+    int index = bin(value);
+    if (counts[index] == 0) return;
+    --counts[index];
+    --total;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (int i = 0; i < BINS; ++i) counts[i] += other.counts[i];
+    total += other.total;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0.0;
+    auto rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    int index = 0;
+    for (; index < BINS - 1; ++index) {
+        seen += counts[index];
+        if (seen > rank) break;
+    }
+    return min + (index + 0.5) * resolution();
+}
+
+std::pair<double, double> LibraryStats::metricBounds(StatMetric metric) {
+    const MetricRange& range = metricRange();
+    int m = static_cast<int>(metric);
+    return {range.min[m], range.max[m]};
+}
+
+LibraryStats::LibraryStats() {
+    const MetricRange& range = metricRange();
+    for (int m = 0; m < STAT_METRIC_COUNT; ++m) quantiles[m] = QuantileSketch(range.min[m], range.max[m]);
+}
+
+void LibraryStats::apply(const DesignParameters& params, bool adding) {
+    DesignMetrics metrics = CarDesign::evaluate(params);
+    const double values[STAT_METRIC_COUNT] = {metrics.speed, metrics.fuelConsumption, metrics.attributes.cost,
+                                              metrics.attributes.mass};
+    for (int m = 0; m < STAT_METRIC_COUNT; ++m) {
+        if (adding) {
+            moments[m].add(values[m]);
+            quantiles[m].add(values[m]);
+        } else {
+            moments[m].remove(values[m]);
+            quantiles[m].remove(values[m]);
+        }
+    }
+    for (int part = 0; part < 4; ++part) {
+        double factor = std::clamp(params.aero[part], 0.5, 1.5);
+        int aeroBin = std::min(static_cast<int>((factor - 0.5) * AERO_BINS), AERO_BINS - 1);
+        uint64_t delta = adding ? 1 : ~uint64_t{0};  // wraps to -1
+        aeroCounts[part][aeroBin] += delta;
+        if (params.parts[part] >= 0 && params.parts[part] < PART_SLOTS) partCounts[part][params.parts[part]] += delta;
+        if (adding) {
+            aero[part].add(factor);
+        } else {
+            aero[part].remove(factor);
+        }
+    }
+}
+
+void LibraryStats::add(const DesignParameters& params) {
+    apply(params, true);
+}
+
+void LibraryStats::remove(const DesignParameters& params) {
+    apply(params, false);
+}
+
+void LibraryStats::merge(const LibraryStats& other) {
+    for (int m = 0; m < STAT_METRIC_COUNT; ++m) {
+        moments[m].merge(other.moments[m]);
+        quantiles[m].merge(other.quantiles[m]);
+    }
+    for (int part = 0; part < 4; ++part) {
+        aero[part].merge(other.aero[part]);
+        for (int i = 0; i < PART_SLOTS; ++i) partCounts[part][i] += other.partCounts[part][i];
+        for (int i = 0; i < AERO_BINS; ++i) aeroCounts[part][i] += other.aeroCounts[part][i];
+    }
+}
+
+MetricSummary LibraryStats::summarize(StatMetric metric) const {
+    int m = static_cast<int>(metric);
+    MetricSummary summary;
+    summary.mean = moments[m].mean;
+    summary.stddev = std::sqrt(moments[m].variance());
+    summary.p10 = quantiles[m].quantile(0.1);
+    summary.median = quantiles[m].quantile(0.5);
+    summary.p90 = quantiles[m].quantile(0.9);
+    return summary;
+}
+
+LibraryStats LibraryStats::compute(const std::vector<DesignParameters>& designs, size_t threads) {
+    size_t chunks = (designs.size() + COMPUTE_CHUNK - 1) / COMPUTE_CHUNK;
+    if (chunks == 0) return LibraryStats();
+    // Each chunk's partial result is allocated by the worker that fills it.
+    std::vector<std::unique_ptr<LibraryStats>> partial(chunks);
+    ThreadPoolExecutor::shared().parallelFor(chunks, threads, [&](size_t chunk) {
+        TRACE_ZONE("LibraryStats::compute chunk");
+        auto stats = std::make_unique<LibraryStats>();
+        size_t end = std::min((chunk + 1) * COMPUTE_CHUNK, designs.size());
+        for (size_t i = chunk * COMPUTE_CHUNK; i < end; ++i) stats->add(designs[i]);
+        partial[chunk] = std::move(stats);
+    });
+
+    // Pairwise tree over the chunks in index order: deterministic, and each
+    // mean is combined from partial results of similar size.
+    for (size_t width = 1; width < chunks; width *= 2) {
+        for (size_t i = 0; i + width < chunks; i += 2 * width) partial[i]->merge(*partial[i + width]);
+    }
+    return *partial[0];
+}
@@ -0,0 +1,104 @@
+#ifndef LIBRARYSTATS_H
+#define LIBRARYSTATS_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class StatMetric { SPEED, FUEL, COST, MASS, COUNT };
+
+const int STAT_METRIC_COUNT = static_cast<int>(StatMetric::COUNT);
+
+// Running count, mean and sum of squared deviations (Welford). Sketches of
+// disjoint sets merge with Chan's pairwise formula; remove() undoes add().
+struct MomentSketch {
+    uint64_t count{0};
+    double mean{0.0};
+    double m2{0.0};
+
+    void add(double value);
+    void remove(double value);
+    void merge(const MomentSketch& other);
+    double variance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+};
+
+// Histogram over a fixed range with QUANTILE_BINS bins. Counts add, remove
+// and merge exactly; quantiles are bin midpoints, so they are within half a
+// bin width of the true value. Values outside the range land in the end bins.
+class QuantileSketch {
+public:
+    static constexpr int BINS = 1024;
+
+    QuantileSketch() = default;
+    QuantileSketch(double min, double max) : min(min), max(max) {}
+
+    void add(double value) {
+        ++counts[bin(value)];
+        ++total;
+    }
+    void remove(double value);
+    void merge(const QuantileSketch& other);
+    double quantile(double q) const;
+    double resolution() const { return (max - min) / BINS; }
+
+private:
+    int bin(double value) const;
+
+    double min{0.0};
+    double max{1.0};
+    uint64_t total{0};
+    uint64_t counts[BINS]{};
+};
+
+struct MetricSummary {
+    double mean{0.0};
+    double stddev{0.0};
+    double p10{0.0};
+    double median{0.0};
+    double p90{0.0};
+};
+
+// Library-wide aggregates that can be updated one design at a time and
+// merged, so the library evaluator keeps them current as designs are saved
+// and deleted instead of recomputing them. Metric ranges come from the part
+// catalogs, so every instance uses the same bins and merges exactly.
+class LibraryStats {
+public:
+    static constexpr int PART_SLOTS = 8;   // part indices counted per part type
+    static constexpr int AERO_BINS = 20;   // over [0.5, 1.5]
+
+    LibraryStats();
+
+    void add(const DesignParameters& params);
+    void remove(const DesignParameters& params);
+    void merge(const LibraryStats& other);
+
+    uint64_t count() const { return moments[0].count; }
+    MetricSummary summarize(StatMetric metric) const;
+    uint64_t partUsage(int part, int designIndex) const { return partCounts[part][designIndex]; }
+    uint64_t aeroCount(int part, int bin) const { return aeroCounts[part][bin]; }
+    const MomentSketch& aeroMoments(int part) const { return aero[part]; }
+
+    // Smallest and largest value metric can take over the part catalogs with
+    // every aero factor in [0.5, 1.5].
+    static std::pair<double, double> metricBounds(StatMetric metric);
+
+    // Recomputes from scratch on up to `threads` threads of the shared compute
+    // pool, the caller included (0 for all of them). Work is split into
+    // fixed chunks whose partial results are merged in a fixed pairwise
+    // order, so the result does not depend on the thread count.
+    static LibraryStats compute(const std::vector<DesignParameters>& designs, size_t threads = 0);
+
+private:
+    void apply(const DesignParameters& params, bool adding);
+
+    MomentSketch moments[STAT_METRIC_COUNT];
+    QuantileSketch quantiles[STAT_METRIC_COUNT];
+    MomentSketch aero[4];
+    uint64_t partCounts[4][PART_SLOTS]{};
+    uint64_t aeroCounts[4][AERO_BINS]{};
+};
+
+#endif
@@ -0,0 +1,512 @@
+#include "LibraryTransfer.h"
+#include "ConfigurationManager.h"
+#include "LibraryIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+const char CSV_HEADER[] = "Name,FrontWing,RearWing,Diffuser,Sidepods,FrontWingAero,RearWingAero,DiffuserAero,SidepodsAero,"
+                          "Drag,Mass,Cost,Speed,Fuel\n";
+const char COLUMNAR_MAGIC[4] = {'F', '1', 'C', 'T'};
+const uint32_t COLUMNAR_VERSION = 1;
+const int DERIVED_COLUMNS = 5;
+// Aero and derived doubles, part bytes and the name length; the name itself is extra.
+const size_t COLUMNAR_ROW_BYTES = (4 + DERIVED_COLUMNS) * sizeof(double) + 4 + sizeof(uint16_t);
+const size_t CSV_BLOCK_BYTES = 4 << 20;
+const uint32_t MAX_PAYLOAD_BYTES = 256u << 20;
+
+size_t inFlightLimit(const ThreadPoolExecutor& pool, size_t threads) {
+    return 2 * (threads > 0 ? threads : pool.threadCount() + 1);
+}
+
+void derivedValues(const DesignParameters& params, double values[DERIVED_COLUMNS]) {
+    DesignMetrics metrics = CarDesign::evaluate(params);
+    values[0] = metrics.attributes.drag;
+    values[1] = metrics.attributes.mass;
+    values[2] = metrics.attributes.cost;
+    values[3] = metrics.speed;
+    values[4] = metrics.fuelConsumption;
+}
+
+// Shortest text that reads back as the same double.
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendNumber(std::string& out, int value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+std::string encodeCsv(const std::vector<TransferRow>& rows) {
+    std::string out;
+    out.reserve(rows.size() * 160);
+    double derived[DERIVED_COLUMNS];
+    for (const auto& row : rows) {
+        out += row.name;
+        for (int i = 0; i < 4; ++i) {
+            out += ',';
+            appendNumber(out, row.params.parts[i]);
+        }
+        for (int i = 0; i < 4; ++i) {
+            out += ',';
+            appendNumber(out, row.params.aero[i]);
+        }
+        derivedValues(row.params, derived);
+        for (double value : derived) {
+            out += ',';
+            appendNumber(out, value);
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+template <typename T>
+void appendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readRaw(const char*& cursor) {
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+std::string encodeColumnar(const std::vector<TransferRow>& rows) {
+    size_t count = rows.size();
+    size_t nameBytes = 0;
+    for (const auto& row : rows) nameBytes += row.name.size();
+    size_t payloadBytes = count * COLUMNAR_ROW_BYTES + nameBytes;
+    size_t padding = (8 - payloadBytes % 8) % 8;
+
+    std::string out;
+    out.reserve(8 + payloadBytes + padding);
+    appendRaw(out, static_cast<uint32_t>(count));
+    appendRaw(out, static_cast<uint32_t>(payloadBytes + padding));
+    for (int i = 0; i < 4; ++i) {
+        for (const auto& row : rows) appendRaw(out, row.params.aero[i]);
+    }
+    std::vector<double> derived(count * DERIVED_COLUMNS);
+    for (size_t r = 0; r < count; ++r) {
+        double values[DERIVED_COLUMNS];
+        derivedValues(rows[r].params, values);
+        for (int c = 0; c < DERIVED_COLUMNS; ++c) derived[c * count + r] = values[c];
+    }
+    out.append(reinterpret_cast<const char*>(derived.data()), derived.size() * sizeof(double));
+    for (int i = 0; i < 4; ++i) {
+        for (const auto& row : rows) out += static_cast<char>(static_cast<uint8_t>(row.params.parts[i]));
+    }
+    for (const auto& row : rows) appendRaw(out, static_cast<uint16_t>(row.name.size()));
+    for (const auto& row : rows) out += row.name;
+    out.append(padding, '\0');
+    return out;
+}
+
+std::vector<TransferRow> decodeColumnar(const std::string& payload, uint32_t count) {
+    size_t fixedBytes = static_cast<size_t>(count) * COLUMNAR_ROW_BYTES;
+    if (payload.size() < fixedBytes) throw std::runtime_error("Corrupted columnar file");
+    std::vector<TransferRow> rows(count);
+    const char* cursor = payload.data();
+    for (int i = 0; i < 4; ++i) {
+        for (auto& row : rows) row.params.aero[i] = readRaw<double>(cursor);
+    }
+    cursor += static_cast<size_t>(count) * DERIVED_COLUMNS * sizeof(double);  // recomputed from the parameters
+    for (int i = 0; i < 4; ++i) {
+        for (auto& row : rows) row.params.parts[i] = static_cast<uint8_t>(*cursor++);
+    }
+    const char* lengths = cursor;
+    const char* names = cursor + static_cast<size_t>(count) * sizeof(uint16_t);
+    const char* end = payload.data() + payload.size();
+    for (auto& row : rows) {
+        uint16_t length = readRaw<uint16_t>(lengths);
+        if (length > end - names) throw std::runtime_error("Corrupted columnar file");
+        row.name.assign(names, length);
+        names += length;
+    }
+    return rows;
+}
+
+// Parses "name,parts x4,aero x4[,derived...]" lines; malformed lines are counted, not fatal.
+void decodeCsvLines(const std::string& block, std::vector<TransferRow>& rows, uint64_t& rejected) {
+    const char* cursor = block.data();
+    const char* end = cursor + block.size();
+    while (cursor < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (!lineEnd) lineEnd = end;
+        const char* fieldEnd = lineEnd > cursor && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+        if (fieldEnd > cursor) {
+            TransferRow row;
+            const char* comma = static_cast<const char*>(std::memchr(cursor, ',', fieldEnd - cursor));
+            bool valid = comma != nullptr;
+            if (valid) {
+                row.name.assign(cursor, comma);
+                const char* field = comma + 1;
+                for (int i = 0; i < 8 && valid; ++i) {
+                    std::from_chars_result result;
+                    if (i < 4) {
+                        result = std::from_chars(field, fieldEnd, row.params.parts[i]);
+                    } else {
+                        result = std::from_chars(field, fieldEnd, row.params.aero[i - 4]);
+                    }
+                    // A line that ends before the eighth field is short, not just finished.
+                    valid = result.ec == std::errc() && (result.ptr == fieldEnd ? i == 7 : *result.ptr == ',');
+                    field = result.ptr + 1;
+                }
+            }
+            if (valid) {
+                rows.push_back(std::move(row));
+            } else {
+                ++rejected;
+            }
+        }
+        cursor = lineEnd + 1;
+    }
+}
+
+}
+
+template <typename T>
+class ChunkJob : public std::enable_shared_from_this<ChunkJob<T>> {
+public:
+    explicit ChunkJob(std::function<T()> work) : work(std::move(work)), result(promise.get_future()) {}
+
+    // Queues the job on pool. With no workers (a single-CPU machine) it is
+    // left for take() to run.
+    void postTo(ThreadPoolExecutor& pool) {
+        if (pool.threadCount() == 0) return;
+        pool.post([self = this->shared_from_this()]() { self->run(); });
+    }
+    // The job's result, running it on this thread if no worker has started it.
+    T take() {
+        run();
+        return result.get();
+    }
+    // Makes sure the job never starts, or waits for it if it already has.
+    void abandon() {
+        if (claimed.exchange(true, std::memory_order_acq_rel)) result.wait();
+    }
+
+private:
+    void run() {
+        if (claimed.exchange(true, std::memory_order_acq_rel)) return;
+        // The work goes before the result is published: a waiter may free
+        // whatever it refers to as soon as it wakes.
+        try {
+            T value = work();
+            work = nullptr;
+            promise.set_value(std::move(value));
+        } catch (...) {
+            work = nullptr;
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    std::atomic<bool> claimed{false};
+    std::function<T()> work;
+    std::promise<T> promise;
+    std::future<T> result;
+};
+
+DesignTableWriter::DesignTableWriter(const std::string& path, TransferFormat format, size_t threads)
+    : file(path, std::ios::binary | std::ios::trunc), format(format), pool(ThreadPoolExecutor::shared()),
+      maxInFlight(inFlightLimit(pool, threads)) {
+    if (!file.is_open()) throw std::runtime_error("Failed to create " + path);
+    if (format == TransferFormat::CSV) {
+        file.write(CSV_HEADER, sizeof(CSV_HEADER) - 1);
+        stats.bytes = sizeof(CSV_HEADER) - 1;
+    } else {
+        std::string header(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+        appendRaw(header, COLUMNAR_VERSION);
+        appendRaw(header, static_cast<uint32_t>(CHUNK_ROWS));
+        appendRaw(header, uint32_t{0});
+        file.write(header.data(), header.size());
+        stats.bytes = header.size();
+    }
+    pending.reserve(CHUNK_ROWS);
+}
+
+DesignTableWriter::~DesignTableWriter() {
+    if (!finished) {
+        try {
+            finish();
+        } catch (const std::exception& e) {
+            // Log error but don't throw
+        }
+    }
+    // After a failed write the chunks behind it are still queued, and their
+    // producers may refer to the caller's locals.
+    for (auto& job : inFlight) job->abandon();
+}
+
+void DesignTableWriter::write(const std::string& name, const DesignParameters& params) {
+    pending.push_back(TransferRow{name, params});
+    if (pending.size() == CHUNK_ROWS) flushPending();
+}
+
+void DesignTableWriter::flushPending() {
+    if (pending.empty()) return;
+    auto rows = std::make_shared<std::vector<TransferRow>>(std::move(pending));
+    pending.clear();
+    pending.reserve(CHUNK_ROWS);
+    writeChunk([rows]() { return std::move(*rows); });
+}
+
+void DesignTableWriter::writeChunk(std::function<std::vector<TransferRow>()> produce) {
+    if (finished) throw std::runtime_error("Export already finished");
+    while (inFlight.size() >= maxInFlight) writeFront();
+    TransferFormat chunkFormat = format;
+    inFlight.push_back(std::make_shared<ChunkJob<EncodedChunk>>([produce = std::move(produce), chunkFormat]() {
+        std::vector<TransferRow> rows = produce();
+        EncodedChunk chunk;
+        chunk.rows = rows.size();
+        chunk.bytes = chunkFormat == TransferFormat::CSV ? encodeCsv(rows) : encodeColumnar(rows);
+        return chunk;
+    }));
+    inFlight.back()->postTo(pool);
+}
+
+void DesignTableWriter::writeFront() {
+    std::shared_ptr<ChunkJob<EncodedChunk>> job = std::move(inFlight.front());
+    inFlight.pop_front();
+    EncodedChunk chunk = job->take();
+    // An empty columnar chunk would read as the end marker.
+    if (chunk.rows == 0) return;
+    file.write(chunk.bytes.data(), chunk.bytes.size());
+    stats.rows += chunk.rows;
+    stats.bytes += chunk.bytes.size();
+}
+
+TransferStats DesignTableWriter::finish() {
+    if (finished) return stats;
+    flushPending();
+    finished = true;
+    while (!inFlight.empty()) writeFront();
+    if (format == TransferFormat::COLUMNAR) {
+        std::string trailer;
+        appendRaw(trailer, uint32_t{0});
+        appendRaw(trailer, static_cast<uint32_t>(sizeof(uint64_t)));
+        appendRaw(trailer, stats.rows);
+        file.write(trailer.data(), trailer.size());
+        stats.bytes += trailer.size();
+    }
+    file.close();
+    if (file.fail()) throw std::runtime_error("Failed to write export file");
+    return stats;
+}
+
+DesignTableReader::DesignTableReader(const std::string& path, TransferFormat format, size_t threads)
+    : file(path, std::ios::binary), format(format), pool(ThreadPoolExecutor::shared()),
+      maxInFlight(inFlightLimit(pool, threads)) {
+    if (!file.is_open()) throw std::runtime_error("Failed to open " + path);
+    if (format == TransferFormat::CSV) {
+        std::string header;
+        std::getline(file, header);
+        if (header.compare(0, 5, "Name,") != 0) throw std::runtime_error("Not a design CSV file");
+    } else {
+        char magic[4];
+        uint32_t fields[3];
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(fields), sizeof(fields));
+        if (!file || std::memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) != 0 || fields[0] != COLUMNAR_VERSION) {
+            throw std::runtime_error("Not a design columnar file");
+        }
+    }
+}
+
+DesignTableReader::~DesignTableReader() {
+    // Decodes own their data, so only the ones already running are waited for.
+    for (auto& job : inFlight) job->abandon();
+}
+
+bool DesignTableReader::readCsvBlock(std::string& block) {
+    block.swap(carry);
+    carry.clear();
+    size_t base = block.size();
+    block.resize(base + CSV_BLOCK_BYTES);
+    file.read(&block[base], CSV_BLOCK_BYTES);
+    block.resize(base + static_cast<size_t>(file.gcount()));
+    if (file.gcount() == static_cast<std::streamsize>(CSV_BLOCK_BYTES)) {
+        // Hand the trailing partial line to the next block.
+        size_t lastNewline = block.rfind('\n');
+        if (lastNewline != std::string::npos) {
+            carry.assign(block, lastNewline + 1, std::string::npos);
+            block.resize(lastNewline + 1);
+        }
+    } else {
+        endOfInput = true;
+    }
+    return !block.empty();
+}
+
+bool DesignTableReader::readColumnarChunk(std::string& payload, uint32_t& rows) {
+    uint32_t header[2];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file) throw std::runtime_error("Truncated columnar file");
+    rows = header[0];
+    if (header[1] > MAX_PAYLOAD_BYTES) throw std::runtime_error("Corrupted columnar file");
+    payload.resize(header[1]);
+    file.read(payload.data(), payload.size());
+    if (!file) throw std::runtime_error("Truncated columnar file");
+    if (rows == 0) {
+        if (payload.size() != sizeof(uint64_t)) throw std::runtime_error("Corrupted columnar file");
+        std::memcpy(&expectedRows, payload.data(), sizeof(uint64_t));
+        endOfInput = true;
+        return false;
+    }
+    return true;
+}
+
+void DesignTableReader::fill() {
+    while (!endOfInput && inFlight.size() < maxInFlight) {
+        auto data = std::make_shared<std::string>();
+        if (format == TransferFormat::CSV) {
+            if (!readCsvBlock(*data)) continue;
+            inFlight.push_back(std::make_shared<ChunkJob<DecodedChunk>>([data]() {
+                DecodedChunk chunk;
+                decodeCsvLines(*data, chunk.rows, chunk.rejected);
+                return chunk;
+            }));
+        } else {
+            uint32_t rows = 0;
+            if (!readColumnarChunk(*data, rows)) continue;
+            inFlight.push_back(std::make_shared<ChunkJob<DecodedChunk>>([data, rows]() {
+                DecodedChunk chunk;
+                chunk.rows = decodeColumnar(*data, rows);
+                return chunk;
+            }));
+        }
+        inFlight.back()->postTo(pool);
+    }
+}
+
+bool DesignTableReader::next(std::vector<TransferRow>& rows) {
+    fill();
+    if (inFlight.empty()) {
+        if (format == TransferFormat::COLUMNAR && rowsDecoded != expectedRows) {
+            throw std::runtime_error("Truncated columnar file");
+        }
+        rows.clear();
+        return false;
+    }
+    std::shared_ptr<ChunkJob<DecodedChunk>> job = std::move(inFlight.front());
+    inFlight.pop_front();
+    DecodedChunk chunk = job->take();
+    rows = std::move(chunk.rows);
+    rowsDecoded += rows.size();
+    rejected += chunk.rejected;
+    fill();
+    return true;
+}
+
+TransferFormat LibraryTransfer::formatForPath(const std::string& path) {
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == ".csv" ? TransferFormat::CSV : TransferFormat::COLUMNAR;
+}
+
+TransferStats LibraryTransfer::exportLibrary(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> names = ConfigurationManager::getDesignFiles();
+    // Each chunk loads through an arena of its own, released when the chunk is done.
+    DesignArenaPool arenas;
+    DesignTableWriter writer(path, formatForPath(path));
+    for (size_t begin = 0; begin < names.size(); begin += DesignTableWriter::CHUNK_ROWS) {
+        size_t end = std::min(begin + DesignTableWriter::CHUNK_ROWS, names.size());
+        writer.writeChunk([&names, &arenas, begin, end]() {
+            std::vector<TransferRow> rows;
+            rows.reserve(end - begin);
+            DesignArenaPool::Lease arena = arenas.acquire();
+            CarDesign design(arena->resource());
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    {
+                        DesignArena::HeapWatch watch(*arena);
+                        design.loadFromFile(names[i]);
+                    }
+                    rows.push_back(TransferRow{names[i], design.getParameters()});
+                } catch (const std::exception& e) {
+                    // Skip corrupted files
+                }
+            }
+            return rows;
+        });
+    }
+    TransferStats stats = writer.finish();
+    stats.skipped = names.size() - stats.rows;
+    stats.allocations = arenas.stats();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+TransferStats LibraryTransfer::importLibrary(const std::string& path, bool overwrite) {
+    auto start = std::chrono::steady_clock::now();
+    ConfigurationManager::ensureDesignsDirectory();
+    DesignTableReader reader(path, formatForPath(path));
+    TransferStats stats;
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    std::vector<TransferRow> rows;
+    // Rows of a chunk are written in parallel in batches of distinct names,
+    // so a name repeated within a chunk is still saved in file order.
+    std::vector<size_t> batch;
+    std::unordered_set<std::string_view> batchNames;
+    std::vector<uint8_t> saved;
+    std::vector<std::pair<std::string, DesignParameters>> upserts;
+    auto saveBatch = [&]() {
+        saved.assign(batch.size(), 0);
+        ThreadPoolExecutor::shared().parallelFor(batch.size(), 0, [&](size_t i) {
+            const TransferRow& row = rows[batch[i]];
+            try {
+                auto [isValid, error] = CarDesign::validateDesignName(row.name);
+                if (!isValid || (!overwrite && ConfigurationManager::designExists(row.name))) return;
+                CarDesign design;
+                design.setParameters(row.params);
+                ConfigurationManager::writeDesign(design, row.name);
+                saved[i] = 1;
+            } catch (const std::exception& e) {
+                // Invalid part indices or unwritable files only skip the row
+            }
+        });
+        // The index is not thread-safe: it takes the whole batch here, in one write.
+        upserts.clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (saved[i]) upserts.emplace_back(rows[batch[i]].name, rows[batch[i]].params);
+        }
+        stats.rows += upserts.size();
+        stats.skipped += batch.size() - upserts.size();
+        try {
+            index.upsert(upserts);
+        } catch (const std::exception& e) {
+            index.invalidate();
+        }
+        batch.clear();
+        batchNames.clear();
+    };
+    while (reader.next(rows)) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (batchNames.count(rows[i].name)) saveBatch();
+            batchNames.insert(rows[i].name);
+            batch.push_back(i);
+        }
+        saveBatch();
+    }
+    stats.skipped += reader.rejectedRows();
+    stats.bytes = static_cast<uint64_t>(std::filesystem::file_size(path));
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
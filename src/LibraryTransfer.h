@@ -0,0 +1,139 @@
+#ifndef LIBRARYTRANSFER_H
+#define LIBRARYTRANSFER_H
+
+#include "CarDesign.h"
+#include "DesignArena.h"
+#include "TaskRuntime.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// CSV for spreadsheets; the columnar format (.f1cols) for analysis tools.
+enum class TransferFormat { CSV, COLUMNAR };
+
+struct TransferRow {
+    std::string name;
+    DesignParameters params;
+};
+
+struct TransferStats {
+    uint64_t rows{0};      // designs written or imported
+    uint64_t skipped{0};   // unreadable designs, rejected rows or names kept on import
+    uint64_t bytes{0};     // size of the transfer file
+    double seconds{0.0};
+    AllocationStats allocations;  // CarDesign allocations made while loading designs for export
+};
+
+// A chunk's encode or decode, run by whichever of a pool worker and the
+// thread waiting for it gets there first (see LibraryTransfer.cpp).
+template <typename T>
+class ChunkJob;
+
+// Both formats carry one row per design: name, the four part indices, the
+// four aero factors and the derived drag, mass, cost, speed and fuel.
+//
+// CSV has a header line and one design per line. Derived columns are
+// ignored on import and recomputed.
+//
+// The columnar file is "F1CT" | uint32 version | uint32 chunkRows | uint32 0,
+// then chunks of uint32 rows | uint32 payloadBytes | payload, where the
+// payload holds double aero[4][rows], double derived[5][rows],
+// uint8 parts[4][rows], uint16 nameLength[rows] and the name bytes, padded
+// to 8 bytes so every chunk's doubles stay aligned in the file. A chunk of
+// zero rows carrying the uint64 total row count ends the file.
+//
+// Rows are buffered into chunks of CHUNK_ROWS that are encoded or decoded
+// on the shared compute pool while the calling thread does the file I/O in
+// order. A chunk no worker has started by the time its turn comes is run by
+// the calling thread itself. At most two chunks per thread are in flight
+// (threads, or else the shared pool's workers plus the caller), so memory
+// stays constant whatever the size of the file.
+class DesignTableWriter {
+public:
+    static constexpr size_t CHUNK_ROWS = 16384;
+
+    DesignTableWriter(const std::string& path, TransferFormat format, size_t threads = 0);
+    ~DesignTableWriter();
+    DesignTableWriter(const DesignTableWriter&) = delete;
+    DesignTableWriter& operator=(const DesignTableWriter&) = delete;
+
+    void write(const std::string& name, const DesignParameters& params);
+    // Queues a whole chunk produced on a worker thread, so loading the rows
+    // overlaps with encoding and writing earlier chunks.
+    void writeChunk(std::function<std::vector<TransferRow>()> produce);
+    // Writes everything queued and closes the file. Throws if any write failed.
+    TransferStats finish();
+
+private:
+    struct EncodedChunk {
+        uint64_t rows{0};
+        std::string bytes;
+    };
+
+    void flushPending();
+    void writeFront();
+
+    std::ofstream file;
+    TransferFormat format;
+    ThreadPoolExecutor& pool;
+    size_t maxInFlight;
+    std::deque<std::shared_ptr<ChunkJob<EncodedChunk>>> inFlight;
+    std::vector<TransferRow> pending;
+    TransferStats stats;
+    bool finished{false};
+};
+
+class DesignTableReader {
+public:
+    DesignTableReader(const std::string& path, TransferFormat format, size_t threads = 0);
+    ~DesignTableReader();
+    DesignTableReader(const DesignTableReader&) = delete;
+    DesignTableReader& operator=(const DesignTableReader&) = delete;
+
+    // Replaces rows with the next chunk in file order; false at the end.
+    // Throws std::runtime_error if the file is corrupted.
+    bool next(std::vector<TransferRow>& rows);
+    // CSV lines that could not be parsed.
+    uint64_t rejectedRows() const { return rejected; }
+
+private:
+    struct DecodedChunk {
+        std::vector<TransferRow> rows;
+        uint64_t rejected{0};
+    };
+
+    void fill();
+    bool readCsvBlock(std::string& block);
+    bool readColumnarChunk(std::string& payload, uint32_t& rows);
+
+    std::ifstream file;
+    TransferFormat format;
+    ThreadPoolExecutor& pool;
+    size_t maxInFlight;
+    std::deque<std::shared_ptr<ChunkJob<DecodedChunk>>> inFlight;
+    std::string carry;  // CSV: partial line left over from the previous block
+    bool endOfInput{false};
+    uint64_t rowsDecoded{0};
+    uint64_t expectedRows{0};
+    uint64_t rejected{0};
+};
+
+// Bulk export and import of the saved library.
+class LibraryTransfer {
+public:
+    // .csv selects CSV; anything else the columnar format.
+    static TransferFormat formatForPath(const std::string& path);
+    // Loads every saved design in parallel and streams it to path.
+    static TransferStats exportLibrary(const std::string& path);
+    // Saves every valid row as a design, each chunk's rows in parallel.
+    // Existing designs are kept unless overwrite is set, in which case their
+    // previous version is recorded.
+    static TransferStats importLibrary(const std::string& path, bool overwrite);
+};
+
+#endif
@@ -0,0 +1,255 @@
+#include "ResultCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'F', '1', 'R', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t CACHE_FORMAT = 1;
+
+uint64_t mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+uint64_t bits(double value) {
+    if (value == 0.0) value = 0.0;  // -0.0 and 0.0 hash alike
+    uint64_t result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+double fromBits(uint64_t value) {
+    double result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+uint64_t mixAttributes(uint64_t hash, const PartAttributes& attributes) {
+    hash = mix(hash, bits(attributes.drag));
+    hash = mix(hash, bits(attributes.mass));
+    return mix(hash, bits(attributes.cost));
+}
+
+}
+
+ResultCache::ResultCache(const std::string& path, size_t budgetBytes) {
+    size_t sets = std::max<size_t>(1, (std::max(budgetBytes, sizeof(Header)) - sizeof(Header)) / sizeof(Set));
+    if (path == DEFAULT_PATH) {
+        // Earlier versions kept the file in designs/
+        std::error_code ignored;
+        fs::remove("designs/results.f1cache", ignored);
+    }
+    openFile(path, sets);
+    // Without the file the cache still works, it just ends with the session
+    if (!header) useMemory(sets);
+}
+
+ResultCache::~ResultCache() {
+#ifndef _WIN32
+    if (fd >= 0) {
+        munmap(mapping, mappingSize);
+        close(fd);
+        return;
+    }
+#endif
+    ::operator delete(mapping, std::align_val_t{alignof(Set)});
+}
+
+void ResultCache::openFile(const std::string& path, size_t sets) {
+#ifndef _WIN32
+    std::error_code error;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, error);
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) return;
+    struct stat info;
+    size_t size = sizeof(Header) + sets * sizeof(Set);
+    // Another process holds the cache
+    if (flock(file, LOCK_EX | LOCK_NB) != 0 || fstat(file, &info) != 0) {
+        close(file);
+        return;
+    }
+    bool sized = static_cast<size_t>(info.st_size) == size;
+    if (!sized && (ftruncate(file, 0) != 0 || ftruncate(file, static_cast<off_t>(size)) != 0)) {
+        close(file);
+        return;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (memory == MAP_FAILED) {
+        close(file);
+        return;
+    }
+    fd = file;
+    mapping = memory;
+    mappingSize = size;
+    header = static_cast<Header*>(memory);
+    this->sets = reinterpret_cast<Set*>(static_cast<char*>(memory) + sizeof(Header));
+    setCount = sets;
+    uint64_t fingerprint = modelFingerprint();
+    if (!sized || std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header->format != CACHE_FORMAT ||
+        header->ways != WAYS || header->sets != sets || header->fingerprint != fingerprint) {
+        initialize(sets);
+        return;
+    }
+    // A set left odd belongs to a writer that died mid-store; nobody else has the file open.
+    for (size_t i = 0; i < setCount; ++i) {
+        Set& set = this->sets[i];
+        uint32_t version = set.version.load(std::memory_order_relaxed);
+        if ((version & 1) == 0) continue;
+        for (auto& slot : set.slots) slot.hash.store(0, std::memory_order_relaxed);
+        set.version.store(version + 1, std::memory_order_relaxed);
+    }
+#else
+    (void)path;
+    (void)sets;
+#endif
+}
+
+void ResultCache::useMemory(size_t sets) {
+    mappingSize = sizeof(Header) + sets * sizeof(Set);
+    mapping = ::operator new(mappingSize, std::align_val_t{alignof(Set)});
+    header = static_cast<Header*>(mapping);
+    this->sets = reinterpret_cast<Set*>(static_cast<char*>(mapping) + sizeof(Header));
+    setCount = sets;
+    initialize(sets);
+}
+
+void ResultCache::initialize(size_t sets) {
+    Header* fresh = new (header) Header();
+    std::memcpy(fresh->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    fresh->format = CACHE_FORMAT;
+    fresh->ways = WAYS;
+    fresh->sets = sets;
+    fresh->fingerprint = modelFingerprint();
+    fresh->clock.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < sets; ++i) new (&this->sets[i]) Set();
+}
+
+size_t ResultCache::entries() const {
+    size_t count = 0;
+    for (size_t i = 0; i < setCount; ++i) {
+        for (const auto& slot : sets[i].slots) count += slot.hash.load(std::memory_order_relaxed) != 0;
+    }
+    return count;
+}
+
+bool ResultCache::lookup(const ResultKey& key, double* values) {
+    Set& set = sets[key.hash % setCount];
+    uint32_t version = set.version.load(std::memory_order_acquire);
+    if ((version & 1) == 0) {
+        for (auto& slot : set.slots) {
+            if (slot.hash.load(std::memory_order_relaxed) != key.hash || slot.check.load(std::memory_order_relaxed) != key.check) {
+                continue;
+            }
+            uint64_t copied[VALUES];
+            for (int i = 0; i < VALUES; ++i) copied[i] = slot.values[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (set.version.load(std::memory_order_relaxed) != version) break;
+            for (int i = 0; i < VALUES; ++i) values[i] = fromBits(copied[i]);
+            slot.lastUsed.store(header->clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            ++hitCount;
+            return true;
+        }
+    }
+    ++missCount;
+    return false;
+}
+
+void ResultCache::store(const ResultKey& key, const double* values) {
+    Set& set = sets[key.hash % setCount];
+    uint32_t version = set.version.load(std::memory_order_relaxed);
+    // Another writer holds the set; the result is simply not cached
+    if ((version & 1) != 0 || !set.version.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) return;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot* target = nullptr;
+    for (auto& slot : set.slots) {
+        uint64_t hash = slot.hash.load(std::memory_order_relaxed);
+        if (hash == key.hash && slot.check.load(std::memory_order_relaxed) == key.check) {
+            target = &slot;
+            break;
+        }
+        if (hash == 0 && !target) target = &slot;
+    }
+    if (!target) {
+        target = &set.slots[0];
+        for (auto& slot : set.slots) {
+            if (slot.lastUsed.load(std::memory_order_relaxed) < target->lastUsed.load(std::memory_order_relaxed)) target = &slot;
+        }
+        ++evictionCount;
+    }
+    target->hash.store(key.hash, std::memory_order_relaxed);
+    target->check.store(key.check, std::memory_order_relaxed);
+    for (int i = 0; i < VALUES; ++i) target->values[i].store(bits(values[i]), std::memory_order_relaxed);
+    target->lastUsed.store(header->clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    set.version.store(version + 2, std::memory_order_release);
+}
+
+void ResultCache::clear() {
+    initialize(setCount);
+}
+
+ResultKey ResultCache::makeKey(CachedAnalysis analysis, const DesignParameters& params,
+                               std::initializer_list<double> settings, uint64_t seed) {
+    ResultKey key;
+    uint64_t hash = 0x243F6A8885A308D3ull;
+    uint64_t check = 0x13198A2E03707344ull;
+    auto add = [&](uint64_t value) {
+        hash = mix(hash, value);
+        check = mix(check ^ 0xA4093822299F31D0ull, value);
+    };
+    add(static_cast<uint64_t>(analysis));
+    for (int i = 0; i < 4; ++i) {
+        add(static_cast<uint64_t>(params.parts[i]));
+        add(bits(params.aero[i]));
+    }
+    add(settings.size());
+    for (double setting : settings) add(bits(setting));
+    add(seed);
+    key.hash = hash != 0 ? hash : 1;
+    key.check = check;
+    return key;
+}
+
+uint64_t ResultCache::modelFingerprint() {
+    static const uint64_t fingerprint = []() {
+        uint64_t hash = mix(0, MODEL_VERSION);
+        PartAttributes totals;
+        auto addCatalog = [&](int count, PartAttributes (*attributes)(int)) {
+            hash = mix(hash, static_cast<uint64_t>(count));
+            for (int i = 0; i < count; ++i) {
+                PartAttributes part = attributes(i);
+                hash = mixAttributes(hash, part);
+                totals = totals + part;
+            }
+        };
+        addCatalog(FrontWing::getDesignCount(), &FrontWing::getDesignAttributes);
+        addCatalog(RearWing::getDesignCount(), &RearWing::getDesignAttributes);
+        addCatalog(Diffuser::getDesignCount(), &Diffuser::getDesignAttributes);
+        addCatalog(Sidepods::getDesignCount(), &Sidepods::getDesignAttributes);
+        // Probe the model away from and at the catalog's own totals.
+        const PartAttributes probes[] = {{1.0, 100.0, 10000.0}, {5.0, 400.0, 50000.0}, {0.25, 20.0, 500.0}, totals};
+        for (const auto& probe : probes) {
+            DesignMetrics metrics = CarDesign::evaluate(probe);
+            hash = mix(hash, bits(metrics.speed));
+            hash = mix(hash, bits(metrics.fuelConsumption));
+            hash = mixAttributes(hash, metrics.attributes);
+        }
+        return hash;
+    }();
+    return fingerprint;
+}
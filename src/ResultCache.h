@@ -0,0 +1,110 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "CarDesign.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Analyses whose results are worth keeping between sessions. Values are part
+// of the cache key, so never renumber them.
+enum class CachedAnalysis : uint32_t {
+    MONTE_CARLO = 1,  // mean speed, fuel and cost under aero perturbation
+};
+
+// Two independent hashes of one analysis of one design; both must match.
+struct ResultKey {
+    uint64_t hash{0};
+    uint64_t check{0};
+};
+
+// Disk-backed cache of analysis results (cache/results.f1cache), kept out of
+// designs/ so that creating it leaves the library caches' directory timestamp alone.
+//
+// The file is memory-mapped and laid out as a set-associative hash table:
+// a key picks one set of WAYS slots, and a full set evicts its least recently
+// used slot, so the file never outgrows the byte budget it was created with.
+// The header records a fingerprint of the performance model and the part
+// catalogs; opening a file with a different fingerprint, layout or budget
+// starts it over empty.
+//
+// Each set is guarded by a sequence counter. Lookups never block and miss
+// rather than wait while a set is written, and a store gives up if another
+// writer holds the set, so processes forked after opening can share the
+// mapping. Only one process opens the file at a time; others, and any
+// platform without mmap, get a cache that lasts for the session.
+class ResultCache {
+public:
+    static constexpr int VALUES = 4;   // doubles per result
+    static constexpr int WAYS = 8;     // slots per set
+    static constexpr size_t DEFAULT_BUDGET = size_t{64} << 20;
+    // Bump whenever CarDesign::evaluate changes in a way the fingerprint's
+    // probe evaluations might not catch.
+    static constexpr uint32_t MODEL_VERSION = 1;
+    static constexpr const char* DEFAULT_PATH = "cache/results.f1cache";
+
+    explicit ResultCache(const std::string& path = DEFAULT_PATH, size_t budgetBytes = DEFAULT_BUDGET);
+    ~ResultCache();
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // Whether results persist across sessions.
+    bool persistent() const { return fd >= 0; }
+    size_t capacity() const { return setCount * WAYS; }
+    size_t entries() const;
+
+    bool lookup(const ResultKey& key, double* values);
+    void store(const ResultKey& key, const double* values);
+    void clear();
+
+    // Counters for this instance only.
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+    uint64_t evictions() const { return evictionCount; }
+
+    // Hashes the design canonically (part indices and aero factors) together
+    // with the analysis, its settings and its random seed.
+    static ResultKey makeKey(CachedAnalysis analysis, const DesignParameters& params,
+                             std::initializer_list<double> settings, uint64_t seed = 0);
+    // Hash of MODEL_VERSION, every catalog part's attributes and a set of
+    // probe evaluations of the performance model.
+    static uint64_t modelFingerprint();
+
+private:
+    struct alignas(64) Header {
+        char magic[8];
+        uint32_t format;
+        uint32_t ways;
+        uint64_t sets;
+        uint64_t fingerprint;
+        std::atomic<uint64_t> clock;   // advanced by every store, stamps slot use
+    };
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> hash;    // 0 when empty
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> lastUsed;
+        std::atomic<uint64_t> values[VALUES];  // bit patterns of the doubles
+    };
+    struct Set {
+        alignas(64) std::atomic<uint32_t> version;  // odd while a store is in progress
+        Slot slots[WAYS];
+    };
+
+    void openFile(const std::string& path, size_t sets);
+    void useMemory(size_t sets);
+    void initialize(size_t sets);
+
+    Header* header{nullptr};
+    Set* sets{nullptr};
+    size_t setCount{0};
+    void* mapping{nullptr};
+    size_t mappingSize{0};
+    int fd{-1};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "ScalingBenchmark.h"
+#include "CarDesign.h"
+#include "CpuTopology.h"
+#include "LibraryStats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+
+const uint64_t STOP_CHECK_MASK = 255;          // items between checks of the stop flag
+const size_t COPY_BLOCK = size_t{1} << 20;
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// The same design for a given seed and index whichever thread builds it.
+DesignParameters designAt(uint64_t seed, size_t index) {
+    static const int partCounts[4] = {FrontWing::getDesignCount(), RearWing::getDesignCount(),
+                                      Diffuser::getDesignCount(), Sidepods::getDesignCount()};
+    uint64_t rng = seed ^ (static_cast<uint64_t>(index) * 0xD1B54A32D192ED03ull);
+    DesignParameters params;
+    for (int i = 0; i < 4; ++i) {
+        params.parts[i] = static_cast<int>(splitmix64(rng) % static_cast<uint64_t>(partCounts[i]));
+        params.aero[i] = 0.5 + (splitmix64(rng) >> 11) * 0x1.0p-53;
+    }
+    return params;
+}
+
+// One worker's share of a measurement. Pinned workers fill the own* buffers
+// themselves; otherwise the pointers are slices of buffers the caller filled.
+struct WorkerSlice {
+    const DesignParameters* designs{nullptr};
+    DesignMetrics* metrics{nullptr};
+    size_t count{0};
+    char* copySource{nullptr};
+    char* copyTarget{nullptr};
+    size_t copyBytes{0};
+    std::vector<DesignParameters> ownDesigns;
+    std::vector<DesignMetrics> ownMetrics;
+    std::vector<char> ownSource;
+    std::vector<char> ownTarget;
+    std::unique_ptr<LibraryStats> stats;
+};
+
+// Runs prepare(worker) on every worker, then work(worker, stop) on all of
+// them at once for about `seconds`. Returns the items done and the time taken.
+std::pair<uint64_t, double> measure(size_t threads, bool pinned, double seconds,
+                                    const std::function<void(size_t)>& prepare,
+                                    const std::function<uint64_t(size_t, const std::atomic<bool>&)>& work) {
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> done(threads, 0);
+    auto worker = [&](size_t index) {
+        if (pinned) CpuTopology::pinCurrentThread(CpuTopology::current().cpuForWorker(index));
+        prepare(index);
+        ready.fetch_add(1, std::memory_order_release);
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        done[index] = work(index, stop);
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) workers.emplace_back(worker, t);
+    while (ready.load(std::memory_order_acquire) < threads) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& thread : workers) thread.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t items = 0;
+    for (uint64_t count : done) items += count;
+    return {items, elapsed};
+}
+
+}
+
+std::vector<size_t> ScalingBenchmark::threadCounts(size_t maxThreads) {
+    std::vector<size_t> counts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(std::max<size_t>(maxThreads, 1));
+    return counts;
+}
+
+std::vector<ScalingPoint> ScalingBenchmark::run(const ScalingSpec& spec, const std::function<void(const ScalingPoint&)>& onPoint) {
+    if (spec.designs == 0 || spec.seconds <= 0.0) throw std::invalid_argument("Invalid scaling benchmark specification");
+    size_t maxThreads = spec.maxThreads > 0 ? spec.maxThreads : CpuTopology::current().cpuCount();
+
+    // Unpinned runs share one batch built here, as the library evaluator and bulk edits do.
+    std::vector<DesignParameters> sharedDesigns;
+    std::vector<DesignMetrics> sharedMetrics;
+    std::vector<char> sharedSource;
+    std::vector<char> sharedTarget;
+    if (!spec.pinned) {
+        sharedDesigns.resize(spec.designs);
+        for (size_t i = 0; i < spec.designs; ++i) sharedDesigns[i] = designAt(spec.seed, i);
+        sharedMetrics.resize(spec.designs);
+    }
+
+    std::vector<ScalingPoint> points;
+    for (ScalingWorkload workload : spec.workloads) {
+        double singleThread = 0.0;
+        for (size_t threads : threadCounts(maxThreads)) {
+            size_t copyShare = std::max(spec.copyBytes / threads, COPY_BLOCK) / COPY_BLOCK * COPY_BLOCK;
+            if (workload == ScalingWorkload::MEMORY_COPY && !spec.pinned) {
+                sharedSource.assign(copyShare * threads, 1);
+                sharedTarget.assign(copyShare * threads, 0);
+            }
+            std::vector<WorkerSlice> slices(threads);
+            auto prepare = [&](size_t index) {
+                WorkerSlice& slice = slices[index];
+                size_t begin = spec.designs * index / threads;
+                size_t end = spec.designs * (index + 1) / threads;
+                slice.count = end - begin;
+                if (workload == ScalingWorkload::MEMORY_COPY) {
+                    slice.copyBytes = copyShare;
+                    if (spec.pinned) {
+                        slice.ownSource.assign(copyShare, 1);
+                        slice.ownTarget.assign(copyShare, 0);
+                        slice.copySource = slice.ownSource.data();
+                        slice.copyTarget = slice.ownTarget.data();
+                    } else {
+                        slice.copySource = sharedSource.data() + copyShare * index;
+                        slice.copyTarget = sharedTarget.data() + copyShare * index;
+                    }
+                } else if (spec.pinned) {
+                    slice.ownDesigns.resize(slice.count);
+                    for (size_t i = 0; i < slice.count; ++i) slice.ownDesigns[i] = designAt(spec.seed, begin + i);
+                    slice.ownMetrics.resize(slice.count);
+                    slice.designs = slice.ownDesigns.data();
+                    slice.metrics = slice.ownMetrics.data();
+                } else {
+                    slice.designs = sharedDesigns.data() + begin;
+                    slice.metrics = sharedMetrics.data() + begin;
+                }
+                if (workload == ScalingWorkload::LIBRARY_STATS) slice.stats = std::make_unique<LibraryStats>();
+            };
+            auto work = [&](size_t index, const std::atomic<bool>& stop) -> uint64_t {
+                WorkerSlice& slice = slices[index];
+                uint64_t items = 0;
+                if (workload == ScalingWorkload::MEMORY_COPY) {
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        for (size_t offset = 0; offset < slice.copyBytes && !stop.load(std::memory_order_relaxed); offset += COPY_BLOCK) {
+                            std::memcpy(slice.copyTarget + offset, slice.copySource + offset, COPY_BLOCK);
+                            items += COPY_BLOCK;
+                        }
+                    }
+                    return items;
+                }
+                if (slice.count == 0) {
+                    while (!stop.load(std::memory_order_relaxed)) std::this_thread::yield();
+                    return 0;
+                }
+                while (true) {
+                    for (size_t i = 0; i < slice.count; ++i) {
+                        if (workload == ScalingWorkload::EVALUATE) {
+                            slice.metrics[i] = CarDesign::evaluate(slice.designs[i]);
+                        } else {
+                            slice.stats->add(slice.designs[i]);
+                        }
+                        if ((++items & STOP_CHECK_MASK) == 0 && stop.load(std::memory_order_relaxed)) return items;
+                    }
+                }
+            };
+            auto [items, elapsed] = measure(threads, spec.pinned, spec.seconds, prepare, work);
+
+            ScalingPoint point;
+            point.workload = workload;
+            point.threads = threads;
+            point.itemsPerSecond = elapsed > 0.0 ? items / elapsed : 0.0;
+            if (threads == 1) singleThread = point.itemsPerSecond;
+            point.speedup = singleThread > 0.0 ? point.itemsPerSecond / singleThread : 0.0;
+            point.efficiency = point.speedup / threads;
+            switch (workload) {
+            case ScalingWorkload::EVALUATE:
+                point.bytesPerSecond = point.itemsPerSecond * (sizeof(DesignParameters) + sizeof(DesignMetrics));
+                break;
+            case ScalingWorkload::LIBRARY_STATS:
+                point.bytesPerSecond = point.itemsPerSecond * sizeof(DesignParameters);
+                break;
+            default:
+                point.bytesPerSecond = point.itemsPerSecond * 2.0;
+                break;
+            }
+            points.push_back(point);
+            if (onPoint) onPoint(point);
+        }
+        sharedSource = std::vector<char>();
+        sharedTarget = std::vector<char>();
+    }
+    return points;
+}
+
+const char* ScalingBenchmark::workloadName(ScalingWorkload workload) {
+    switch (workload) {
+    case ScalingWorkload::EVALUATE: return "evaluate";
+    case ScalingWorkload::LIBRARY_STATS: return "stats";
+    case ScalingWorkload::MEMORY_COPY: return "copy";
+    default: return "unknown";
+    }
+}
+
+bool ScalingBenchmark::parseWorkload(const std::string& text, ScalingWorkload& workload) {
+    for (int i = 0; i < static_cast<int>(ScalingWorkload::COUNT); ++i) {
+        if (text == workloadName(static_cast<ScalingWorkload>(i))) {
+            workload = static_cast<ScalingWorkload>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+#ifndef SCALINGBENCHMARK_H
+#define SCALINGBENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class ScalingWorkload {
+    EVALUATE,       // CarDesign::evaluate over a batch of designs
+    LIBRARY_STATS,  // LibraryStats::add over a batch, as LibraryStats::compute does
+    MEMORY_COPY,    // memcpy between large buffers: the machine's bandwidth ceiling
+    COUNT
+};
+
+struct ScalingSpec {
+    std::vector<ScalingWorkload> workloads{ScalingWorkload::EVALUATE, ScalingWorkload::LIBRARY_STATS,
+                                           ScalingWorkload::MEMORY_COPY};
+    size_t maxThreads{0};          // 0 uses every CPU the process may run on
+    size_t designs{size_t{1} << 20};
+    size_t copyBytes{size_t{256} << 20};  // total source buffer size across workers
+    double seconds{0.5};           // per measurement
+    bool pinned{false};            // pin workers and give each node-local buffers
+    uint64_t seed{1};
+};
+
+struct ScalingPoint {
+    ScalingWorkload workload{ScalingWorkload::EVALUATE};
+    size_t threads{0};
+    double itemsPerSecond{0.0};    // designs, or bytes copied
+    double speedup{0.0};           // over the single-thread run
+    double efficiency{0.0};        // speedup / threads
+    double bytesPerSecond{0.0};    // memory read plus written
+};
+
+// Measures how the bulk workloads scale from one thread to every CPU. Each
+// measurement starts all workers at once and lets them run for a fixed time,
+// so throughput is not skewed by stragglers. Unpinned, the input is one
+// batch filled by the calling thread and workers take slices of it; pinned,
+// workers are spread over the NUMA nodes and build their own slices, which
+// first-touch allocation then places on their node.
+class ScalingBenchmark {
+public:
+    // 1, 2, 4, ... and maxThreads itself.
+    static std::vector<size_t> threadCounts(size_t maxThreads);
+    static std::vector<ScalingPoint> run(const ScalingSpec& spec,
+                                         const std::function<void(const ScalingPoint&)>& onPoint = {});
+
+    static const char* workloadName(ScalingWorkload workload);
+    static bool parseWorkload(const std::string& text, ScalingWorkload& workload);
+};
+
+#endif
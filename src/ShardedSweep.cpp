@@ -0,0 +1,346 @@
+#include "ShardedSweep.h"
+#include "ResultCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#endif
+
+namespace {
+
+const uint64_t RING_CAPACITY = 1 << 16;  // records per worker, power of two
+const uint64_t PUBLISH_BATCH = 64;
+
+struct ResultRecord {
+    uint64_t index;
+    float speed;
+    float fuelConsumption;
+    float cost;
+    uint32_t cached;
+};
+
+// Single-producer/single-consumer ring living in shared memory. The producer
+// only advances tail, the consumer only advances head.
+struct ResultRing {
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) ResultRecord records[RING_CAPACITY];
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory rings need address-free atomics");
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+double gaussian(uint64_t& state) {
+    double u1 = ((splitmix64(state) >> 11) + 1) * 0x1.0p-53;
+    double u2 = (splitmix64(state) >> 11) * 0x1.0p-53;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+bool dominates(const ResultRecord& a, const ResultRecord& b) {
+    return a.speed >= b.speed && a.fuelConsumption <= b.fuelConsumption && a.cost <= b.cost;
+}
+
+}
+
+struct ShardedSweep::Merger {
+    explicit Merger(const SweepSpec& spec)
+        : spec(spec), histogram(static_cast<size_t>(std::max(spec.histogramBins, 1)), 0) {}
+
+    // Fastest first; ties go to the lower candidate index.
+    static bool faster(const std::pair<float, uint64_t>& a, const std::pair<float, uint64_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+
+    void add(const ResultRecord& record) {
+        ++evaluated;
+        cached += record.cached;
+        std::pair<float, uint64_t> entry{record.speed, record.index};
+        if (top.size() < spec.topK) {
+            top.push_back(entry);
+            std::push_heap(top.begin(), top.end(), faster);
+        } else if (spec.topK > 0 && faster(entry, top.front())) {
+            std::pop_heap(top.begin(), top.end(), faster);
+            top.back() = entry;
+            std::push_heap(top.begin(), top.end(), faster);
+        }
+
+        bool dominated = false;
+        for (const auto& member : front) {
+            if (dominates(member, record)) {
+                dominated = true;
+                break;
+            }
+        }
+        if (!dominated) {
+            front.erase(std::remove_if(front.begin(), front.end(),
+                                       [&](const ResultRecord& member) { return dominates(record, member); }),
+                        front.end());
+            front.push_back(record);
+        }
+
+        double range = spec.histogramMax - spec.histogramMin;
+        int bins = static_cast<int>(histogram.size());
+        int bin = range > 0 ? static_cast<int>((record.speed - spec.histogramMin) / range * bins) : 0;
+        ++histogram[std::clamp(bin, 0, bins - 1)];
+    }
+
+    const SweepSpec& spec;
+    std::vector<std::pair<float, uint64_t>> top;
+    std::vector<ResultRecord> front;
+    std::vector<uint64_t> histogram;
+    uint64_t evaluated{0};
+    uint64_t cached{0};
+};
+
+ShardedSweep::ShardedSweep(const SweepSpec& spec) : spec(spec) {
+    if (spec.aeroSteps < 1 || spec.monteCarloSamples < 1) throw std::invalid_argument("Invalid sweep specification");
+    for (int i = 0; i < FrontWing::getDesignCount(); ++i) catalog[0].push_back(FrontWing::getDesignAttributes(i));
+    for (int i = 0; i < RearWing::getDesignCount(); ++i) catalog[1].push_back(RearWing::getDesignAttributes(i));
+    for (int i = 0; i < Diffuser::getDesignCount(); ++i) catalog[2].push_back(Diffuser::getDesignAttributes(i));
+    for (int i = 0; i < Sidepods::getDesignCount(); ++i) catalog[3].push_back(Sidepods::getDesignAttributes(i));
+    totalCandidates = 1;
+    for (int part = 0; part < 4; ++part) {
+        totalCandidates *= catalog[part].size() * static_cast<uint64_t>(spec.aeroSteps);
+    }
+}
+
+ShardedSweep::~ShardedSweep() = default;
+
+DesignParameters ShardedSweep::decode(uint64_t index) const {
+    DesignParameters params;
+    uint64_t steps = static_cast<uint64_t>(spec.aeroSteps);
+    for (int part = 0; part < 4; ++part) {
+        uint64_t step = index % steps;
+        index /= steps;
+        params.aero[part] = steps == 1 ? (spec.aeroMin + spec.aeroMax) * 0.5
+                                       : spec.aeroMin + (spec.aeroMax - spec.aeroMin) * step / (steps - 1);
+    }
+    for (int part = 3; part >= 0; --part) {
+        params.parts[part] = static_cast<int>(index % catalog[part].size());
+        index /= catalog[part].size();
+    }
+    return params;
+}
+
+SweepCandidate ShardedSweep::evaluate(uint64_t index, bool* cached) const {
+    SweepCandidate candidate;
+    candidate.params = decode(index);
+    // Noise is seeded per candidate so a restarted shard reproduces its results.
+    uint64_t rng = spec.seed ^ (index * 0xD1B54A32D192ED03ull);
+    int samples = spec.aeroTolerance > 0.0 ? spec.monteCarloSamples : 1;
+    if (cached) *cached = false;
+    // A single evaluation is cheaper than a lookup, so only sampled results are cached.
+    ResultKey key;
+    double values[ResultCache::VALUES] = {};
+    if (cache && samples > 1) {
+        key = ResultCache::makeKey(CachedAnalysis::MONTE_CARLO, candidate.params,
+                                   {spec.aeroTolerance, static_cast<double>(samples)}, rng);
+        if (cache->lookup(key, values)) {
+            candidate.speed = values[0];
+            candidate.fuelConsumption = values[1];
+            candidate.cost = values[2];
+            if (cached) *cached = true;
+            return candidate;
+        }
+    }
+    for (int sample = 0; sample < samples; ++sample) {
+        PartAttributes totals;
+        for (int part = 0; part < 4; ++part) {
+            double aero = candidate.params.aero[part];
+            if (spec.aeroTolerance > 0.0) aero += spec.aeroTolerance * gaussian(rng);
+            totals = totals + catalog[part][candidate.params.parts[part]] * std::clamp(aero, 0.5, 1.5);
+        }
+        DesignMetrics metrics = CarDesign::evaluate(totals);
+        candidate.speed += metrics.speed;
+        candidate.fuelConsumption += metrics.fuelConsumption;
+        candidate.cost += metrics.attributes.cost;
+    }
+    candidate.speed /= samples;
+    candidate.fuelConsumption /= samples;
+    candidate.cost /= samples;
+    if (cache && samples > 1) {
+        values[0] = candidate.speed;
+        values[1] = candidate.fuelConsumption;
+        values[2] = candidate.cost;
+        cache->store(key, values);
+    }
+    return candidate;
+}
+
+void ShardedSweep::runShard(uint64_t begin, uint64_t end, void* ringMemory, int64_t crashAfter) const {
+    ResultRing* ring = static_cast<ResultRing*>(ringMemory);
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    int64_t produced = 0;
+    for (uint64_t index = begin; index < end; ++index) {
+        while (tail - ring->head.load(std::memory_order_acquire) >= RING_CAPACITY) {
+            ring->tail.store(tail, std::memory_order_release);
+#ifndef _WIN32
+            if (getppid() == 1) _exit(1);  // coordinator is gone
+#endif
+            std::this_thread::yield();
+        }
+        bool cached = false;
+        SweepCandidate candidate = evaluate(index, &cached);
+        ring->records[tail % RING_CAPACITY] = {index, static_cast<float>(candidate.speed),
+                                               static_cast<float>(candidate.fuelConsumption),
+                                               static_cast<float>(candidate.cost), cached ? 1u : 0u};
+        ++tail;
+        if (tail % PUBLISH_BATCH == 0) ring->tail.store(tail, std::memory_order_release);
+        if (crashAfter >= 0 && ++produced >= crashAfter) {
+            ring->tail.store(tail, std::memory_order_release);
+            std::abort();
+        }
+    }
+    ring->tail.store(tail, std::memory_order_release);
+}
+
+SweepReport ShardedSweep::run() {
+    auto start = std::chrono::steady_clock::now();
+    SweepReport report;
+    Merger merger(spec);
+    // Opened before the workers fork so they inherit the mapping.
+    if (spec.useCache && spec.aeroTolerance > 0.0 && spec.monteCarloSamples > 1 && !cache) {
+        cache = std::make_unique<ResultCache>();
+    }
+    int workers = static_cast<int>(std::clamp<uint64_t>(static_cast<uint64_t>(std::max(spec.workers, 1)), 1,
+                                                        std::max<uint64_t>(totalCandidates, 1)));
+    struct Shard {
+        uint64_t begin;
+        uint64_t end;
+        int64_t lastIndex;   // last result received, -1 if none
+        int restarts;
+        bool done;
+        long pid;
+    };
+    std::vector<Shard> shards;
+    for (int w = 0; w < workers; ++w) {
+        uint64_t begin = totalCandidates * w / workers;
+        uint64_t end = totalCandidates * (w + 1) / workers;
+        shards.push_back({begin, end, -1, 0, begin == end, 0});
+    }
+
+#ifdef _WIN32
+    // No fork on Windows: evaluate the shards in-process.
+    for (auto& shard : shards) {
+        for (uint64_t index = shard.begin; index < shard.end; ++index) {
+            bool cached = false;
+            SweepCandidate candidate = evaluate(index, &cached);
+            merger.add({index, static_cast<float>(candidate.speed), static_cast<float>(candidate.fuelConsumption),
+                        static_cast<float>(candidate.cost), cached ? 1u : 0u});
+        }
+        shard.done = true;
+    }
+#else
+    size_t mappingSize = sizeof(ResultRing) * shards.size();
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) throw std::runtime_error("Failed to map sweep shared memory");
+    std::vector<ResultRing*> rings;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        rings.push_back(new (static_cast<char*>(mapping) + i * sizeof(ResultRing)) ResultRing());
+    }
+    pid_t coordinator = getpid();
+    auto launch = [&](size_t shardIndex, uint64_t begin, int64_t crashAfter) {
+        std::fflush(nullptr);
+        pid_t pid = fork();
+        if (pid < 0) throw std::runtime_error("Failed to start sweep worker");
+        if (pid == 0) {
+#ifdef __linux__
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+            if (getppid() != coordinator) _exit(1);
+            runShard(begin, shards[shardIndex].end, rings[shardIndex], crashAfter);
+            _exit(0);
+        }
+        shards[shardIndex].pid = pid;
+    };
+    auto stopAll = [&]() {
+        for (auto& shard : shards) {
+            if (!shard.done && shard.pid > 0) {
+                kill(static_cast<pid_t>(shard.pid), SIGKILL);
+                waitpid(static_cast<pid_t>(shard.pid), nullptr, 0);
+            }
+        }
+        munmap(mapping, mappingSize);
+    };
+    auto drain = [&](size_t shardIndex) {
+        ResultRing* ring = rings[shardIndex];
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head < tail; ++head) {
+            const ResultRecord& record = ring->records[head % RING_CAPACITY];
+            merger.add(record);
+            shards[shardIndex].lastIndex = static_cast<int64_t>(record.index);
+        }
+        ring->head.store(head, std::memory_order_release);
+        return tail;
+    };
+
+    try {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (!shards[i].done) launch(i, shards[i].begin, i == 0 ? spec.crashAfter : -1);
+        }
+        size_t remaining = static_cast<size_t>(std::count_if(shards.begin(), shards.end(),
+                                                             [](const Shard& s) { return !s.done; }));
+        while (remaining > 0) {
+            bool progressed = false;
+            for (size_t i = 0; i < shards.size(); ++i) {
+                Shard& shard = shards[i];
+                if (shard.done) continue;
+                uint64_t before = rings[i]->head.load(std::memory_order_relaxed);
+                progressed |= drain(i) != before;
+                int status = 0;
+                if (waitpid(static_cast<pid_t>(shard.pid), &status, WNOHANG) != static_cast<pid_t>(shard.pid)) continue;
+                drain(i);  // results published right before exit
+                uint64_t resume = shard.lastIndex >= 0 ? static_cast<uint64_t>(shard.lastIndex) + 1 : shard.begin;
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && resume == shard.end) {
+                    shard.done = true;
+                    --remaining;
+                } else {
+                    if (++shard.restarts > spec.maxRestarts) {
+                        shard.pid = 0;
+                        throw std::runtime_error("Sweep shard failed repeatedly");
+                    }
+                    ++report.restarts;
+                    launch(i, resume, -1);
+                }
+                progressed = true;
+            }
+            if (!progressed) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    } catch (...) {
+        stopAll();
+        throw;
+    }
+    munmap(mapping, mappingSize);
+#endif
+
+    std::sort_heap(merger.top.begin(), merger.top.end(), Merger::faster);
+    for (const auto& entry : merger.top) report.top.push_back(evaluate(entry.second));
+    std::sort(merger.front.begin(), merger.front.end(),
+              [](const ResultRecord& a, const ResultRecord& b) { return a.speed != b.speed ? a.speed > b.speed : a.index < b.index; });
+    for (const auto& record : merger.front) report.pareto.push_back(evaluate(record.index));
+    report.speedHistogram = merger.histogram;
+    report.evaluated = merger.evaluated;
+    report.cached = merger.cached;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,80 @@
+#ifndef SHARDEDSWEEP_H
+#define SHARDEDSWEEP_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ResultCache;
+
+struct SweepSpec {
+    int aeroSteps{5};              // grid points per aero axis
+    double aeroMin{0.5};
+    double aeroMax{1.5};
+    int monteCarloSamples{1};      // perturbed evaluations averaged per candidate
+    double aeroTolerance{0.0};     // standard deviation of the aero perturbation
+    bool useCache{true};           // keep Monte Carlo results in the persistent result cache
+    uint64_t seed{1};
+    int workers{4};
+    size_t topK{10};
+    double histogramMin{0.0};      // speed histogram range, km/h
+    double histogramMax{1000.0};
+    int histogramBins{50};
+    int maxRestarts{3};            // per shard
+    int64_t crashAfter{-1};        // fault injection: first run of shard 0 aborts after this many results
+};
+
+struct SweepCandidate {
+    DesignParameters params;
+    double speed{0.0};
+    double fuelConsumption{0.0};
+    double cost{0.0};
+};
+
+struct SweepReport {
+    uint64_t evaluated{0};
+    std::vector<SweepCandidate> top;      // fastest first
+    std::vector<SweepCandidate> pareto;   // max speed, min fuel, min cost
+    std::vector<uint64_t> speedHistogram;
+    int restarts{0};
+    uint64_t cached{0};                   // results served from the result cache
+    double seconds{0.0};
+};
+
+// Sweeps every part combination from the catalogs times an aero grid, with
+// optional Monte Carlo tolerance sampling, across worker processes.
+//
+// The candidate space is split into one contiguous shard per worker. Each
+// worker is forked and streams results through its own single-producer ring
+// buffer in anonymous shared memory; the coordinator drains all rings and
+// merges top-K, the Pareto front and a speed histogram. Results are
+// deterministic per candidate, so a shard whose worker dies is restarted right
+// after the last result it published. On Windows the shards run in-process.
+//
+// Monte Carlo results are looked up in the ResultCache first, which the
+// workers share with the coordinator, so repeating a sweep with the same
+// grid, tolerance, samples and seed mostly reads them back.
+class ShardedSweep {
+public:
+    explicit ShardedSweep(const SweepSpec& spec);
+    ~ShardedSweep();
+
+    uint64_t candidateCount() const { return totalCandidates; }
+    DesignParameters decode(uint64_t index) const;
+    // Sets *cached when the result came from the result cache.
+    SweepCandidate evaluate(uint64_t index, bool* cached = nullptr) const;
+    SweepReport run();
+
+private:
+    struct Merger;
+    void runShard(uint64_t begin, uint64_t end, void* ring, int64_t crashAfter) const;
+
+    SweepSpec spec;
+    std::vector<PartAttributes> catalog[4];
+    uint64_t totalCandidates{0};
+    std::unique_ptr<ResultCache> cache;  // opened by run() for Monte Carlo sweeps
+};
+
+#endif
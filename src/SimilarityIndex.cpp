@@ -0,0 +1,324 @@
+#include "SimilarityIndex.h"
+#include "LibraryStats.h"
+#include "TaskRuntime.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+
+const int D = SIMILARITY_DIMS;
+const size_t MIN_PENDING = 1024;  // pending points tolerated regardless of tree size
+
+struct FeatureScale {
+    double min[D];
+    double range[D];
+};
+
+const FeatureScale& featureScale() {
+    static const FeatureScale scale = []() {
+        FeatureScale result;
+        for (int i = 0; i < 4; ++i) {
+            result.min[i] = 0.5;
+            result.range[i] = 1.0;
+        }
+        const StatMetric metrics[4] = {StatMetric::SPEED, StatMetric::FUEL, StatMetric::COST, StatMetric::MASS};
+        for (int i = 0; i < 4; ++i) {
+            auto bounds = LibraryStats::metricBounds(metrics[i]);
+            result.min[4 + i] = bounds.first;
+            result.range[4 + i] = std::max(bounds.second - bounds.first, 1e-9);
+        }
+        return result;
+    }();
+    return scale;
+}
+
+float normalize(int dim, double value) {
+    const FeatureScale& scale = featureScale();
+    return static_cast<float>((value - scale.min[dim]) / scale.range[dim]);
+}
+
+float denormalize(int dim, float value) {
+    const FeatureScale& scale = featureScale();
+    return static_cast<float>(scale.min[dim] + value * scale.range[dim]);
+}
+
+float distanceSquared(const float* a, const float* b) {
+    float sum = 0.0f;
+    for (int d = 0; d < D; ++d) {
+        float diff = a[d] - b[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+// Read-only view of the tree for the recursive searches.
+struct Tree {
+    const float* points;
+    const uint8_t* live;
+    const uint8_t* splitDims;
+};
+
+using Found = std::pair<float, uint32_t>;  // squared distance, point
+
+// Keeps the k closest points in a max-heap; `bound` is the current k-th distance.
+void searchNearest(const Tree& tree, size_t begin, size_t end, const float* query, size_t k, uint32_t skip,
+                   std::vector<Found>& heap, float& bound) {
+    auto consider = [&](size_t point) {
+        if (!tree.live[point] || point == skip) return;
+        float distance = distanceSquared(tree.points + point * D, query);
+        if (distance >= bound && heap.size() == k) return;
+        heap.push_back({distance, static_cast<uint32_t>(point)});
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > k) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+        if (heap.size() == k) bound = heap.front().first;
+    };
+    if (end - begin <= SimilarityIndex::LEAF_SIZE) {
+        for (size_t point = begin; point < end; ++point) consider(point);
+        return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    int dim = tree.splitDims[mid];
+    float diff = query[dim] - tree.points[mid * D + dim];
+    consider(mid);
+    if (diff < 0.0f) {
+        searchNearest(tree, begin, mid, query, k, skip, heap, bound);
+        if (diff * diff < bound) searchNearest(tree, mid + 1, end, query, k, skip, heap, bound);
+    } else {
+        searchNearest(tree, mid + 1, end, query, k, skip, heap, bound);
+        if (diff * diff < bound) searchNearest(tree, begin, mid, query, k, skip, heap, bound);
+    }
+}
+
+// Calls visit(point) for every live point inside the box [low, high].
+template <typename Visit>
+void searchBox(const Tree& tree, size_t begin, size_t end, const float* low, const float* high, Visit& visit) {
+    auto inside = [&](size_t point) {
+        const float* p = tree.points + point * D;
+        for (int d = 0; d < D; ++d) {
+            if (p[d] < low[d] || p[d] > high[d]) return false;
+        }
+        return tree.live[point] != 0;
+    };
+    if (end - begin <= SimilarityIndex::LEAF_SIZE) {
+        for (size_t point = begin; point < end; ++point) {
+            if (inside(point)) visit(point);
+        }
+        return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    int dim = tree.splitDims[mid];
+    float split = tree.points[mid * D + dim];
+    if (inside(mid)) visit(mid);
+    if (low[dim] <= split) searchBox(tree, begin, mid, low, high, visit);
+    if (high[dim] >= split) searchBox(tree, mid + 1, end, low, high, visit);
+}
+
+}
+
+void SimilarityIndex::features(const DesignParameters& params, float* out) {
+    DesignMetrics metrics = CarDesign::evaluate(params);
+    for (int i = 0; i < 4; ++i) out[i] = normalize(i, std::clamp(params.aero[i], 0.5, 1.5));
+    out[static_cast<int>(SimilarityFeature::SPEED)] = normalize(4, metrics.speed);
+    out[static_cast<int>(SimilarityFeature::FUEL)] = normalize(5, metrics.fuelConsumption);
+    out[static_cast<int>(SimilarityFeature::COST)] = normalize(6, metrics.attributes.cost);
+    out[static_cast<int>(SimilarityFeature::MASS)] = normalize(7, metrics.attributes.mass);
+}
+
+void SimilarityIndex::build(const std::vector<std::string>& designNames, const std::vector<DesignParameters>& params, size_t threads) {
+    TRACE_ZONE("SimilarityIndex::build");
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    points.resize(params.size() * D);
+    names = designNames;
+    live.assign(params.size(), 1);
+    positions.clear();
+    const size_t chunk = std::max<size_t>(1, (params.size() + threads - 1) / threads);
+    ThreadPoolExecutor::shared().parallelFor((params.size() + chunk - 1) / chunk, threads, [&](size_t c) {
+        size_t end = std::min((c + 1) * chunk, params.size());
+        for (size_t i = c * chunk; i < end; ++i) features(params[i], points.data() + i * D);
+    });
+    tombstones = 0;
+    rebuild(threads);
+}
+
+void SimilarityIndex::rebuild(size_t threads) {
+    TRACE_ZONE("SimilarityIndex::rebuild");
+    order.clear();
+    for (size_t point = 0; point < live.size(); ++point) {
+        if (live[point]) order.push_back(static_cast<uint32_t>(point));
+    }
+    splitDims.assign(order.size(), 0);
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // Split the top levels a node per task until there is a subtree for
+    // every thread, then build the subtrees whole. A leaf passes through as
+    // itself plus an empty range.
+    ThreadPoolExecutor& pool = ThreadPoolExecutor::shared();
+    std::vector<std::pair<size_t, size_t>> ranges{{0, order.size()}};
+    while (ranges.size() < threads) {
+        std::vector<std::pair<size_t, size_t>> children(ranges.size() * 2);
+        pool.parallelFor(ranges.size(), threads, [&](size_t r) {
+            auto [begin, end] = ranges[r];
+            if (end - begin <= LEAF_SIZE) {
+                children[2 * r] = {begin, end};
+                children[2 * r + 1] = {end, end};
+                return;
+            }
+            size_t mid = splitRange(begin, end);
+            children[2 * r] = {begin, mid};
+            children[2 * r + 1] = {mid + 1, end};
+        });
+        ranges.swap(children);
+    }
+    pool.parallelFor(ranges.size(), threads, [&](size_t r) { buildRange(ranges[r].first, ranges[r].second); });
+
+    std::vector<float> sortedPoints(order.size() * D);
+    std::vector<std::string> sortedNames(order.size());
+    for (size_t slot = 0; slot < order.size(); ++slot) {
+        std::copy_n(points.data() + static_cast<size_t>(order[slot]) * D, D, sortedPoints.data() + slot * D);
+        sortedNames[slot] = std::move(names[order[slot]]);
+        positions[sortedNames[slot]] = static_cast<uint32_t>(slot);
+    }
+    points.swap(sortedPoints);
+    names.swap(sortedNames);
+    live.assign(order.size(), 1);
+    treeSize = order.size();
+    tombstones = 0;
+    order.clear();
+    order.shrink_to_fit();
+}
+
+void SimilarityIndex::buildRange(size_t begin, size_t end) {
+    if (end - begin <= LEAF_SIZE) return;
+    size_t mid = splitRange(begin, end);
+    buildRange(begin, mid);
+    buildRange(mid + 1, end);
+}
+
+size_t SimilarityIndex::splitRange(size_t begin, size_t end) {
+    float low[D], high[D];
+    std::fill_n(low, D, std::numeric_limits<float>::infinity());
+    std::fill_n(high, D, -std::numeric_limits<float>::infinity());
+    for (size_t slot = begin; slot < end; ++slot) {
+        const float* p = points.data() + static_cast<size_t>(order[slot]) * D;
+        for (int d = 0; d < D; ++d) {
+            low[d] = std::min(low[d], p[d]);
+            high[d] = std::max(high[d], p[d]);
+        }
+    }
+    int dim = 0;
+    for (int d = 1; d < D; ++d) {
+        if (high[d] - low[d] > high[dim] - low[dim]) dim = d;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+        return points[static_cast<size_t>(a) * D + dim] < points[static_cast<size_t>(b) * D + dim];
+    });
+    splitDims[mid] = static_cast<uint8_t>(dim);
+    return mid;
+}
+
+void SimilarityIndex::upsert(const std::string& name, const DesignParameters& params) {
+    remove(name);
+    size_t point = live.size();
+    points.resize(points.size() + D);
+    features(params, points.data() + point * D);
+    names.push_back(name);
+    live.push_back(1);
+    positions[name] = static_cast<uint32_t>(point);
+    size_t pending = live.size() - treeSize;
+    if (pending > std::max(MIN_PENDING, treeSize / 8)) rebuild();
+}
+
+void SimilarityIndex::remove(const std::string& name) {
+    auto it = positions.find(name);
+    if (it == positions.end()) return;
+    live[it->second] = 0;
+    positions.erase(it);
+    if (++tombstones > std::max(MIN_PENDING, treeSize / 4)) rebuild();
+}
+
+std::vector<SimilarMatch> SimilarityIndex::collect(std::vector<std::pair<float, uint32_t>>& found) const {
+    std::sort(found.begin(), found.end());
+    std::vector<SimilarMatch> matches;
+    matches.reserve(found.size());
+    for (const auto& [distance, point] : found) {
+        const float* p = points.data() + static_cast<size_t>(point) * D;
+        SimilarMatch match;
+        match.name = names[point];
+        match.distance = std::sqrt(distance);
+        match.speed = denormalize(4, p[static_cast<int>(SimilarityFeature::SPEED)]);
+        match.fuelConsumption = denormalize(5, p[static_cast<int>(SimilarityFeature::FUEL)]);
+        match.cost = denormalize(6, p[static_cast<int>(SimilarityFeature::COST)]);
+        matches.push_back(std::move(match));
+    }
+    return matches;
+}
+
+std::vector<SimilarMatch> SimilarityIndex::nearest(const DesignParameters& params, size_t k, const std::string& exclude) const {
+    if (k == 0) return {};
+    float query[D];
+    features(params, query);
+    auto excluded = positions.find(exclude);
+    uint32_t skip = excluded != positions.end() ? excluded->second : UINT32_MAX;
+    const Tree tree{points.data(), live.data(), splitDims.data()};
+    std::vector<Found> heap;
+    float bound = std::numeric_limits<float>::infinity();
+    searchNearest(tree, 0, treeSize, query, k, skip, heap, bound);
+    // Pending points are below any tree split, so the leaf scan covers them.
+    for (size_t point = treeSize; point < live.size(); point += LEAF_SIZE) {
+        searchNearest(tree, point, std::min(point + LEAF_SIZE, live.size()), query, k, skip, heap, bound);
+    }
+    return collect(heap);
+}
+
+std::vector<SimilarMatch> SimilarityIndex::withinRadius(const DesignParameters& params, float radius) const {
+    float query[D], low[D], high[D];
+    features(params, query);
+    for (int d = 0; d < D; ++d) {
+        low[d] = query[d] - radius;
+        high[d] = query[d] + radius;
+    }
+    std::vector<Found> found;
+    auto visit = [&](size_t point) {
+        float distance = distanceSquared(points.data() + point * D, query);
+        if (distance <= radius * radius) found.push_back({distance, static_cast<uint32_t>(point)});
+    };
+    const Tree tree{points.data(), live.data(), splitDims.data()};
+    searchBox(tree, 0, treeSize, low, high, visit);
+    for (size_t point = treeSize; point < live.size(); point += LEAF_SIZE) {
+        searchBox(tree, point, std::min(point + LEAF_SIZE, live.size()), low, high, visit);
+    }
+    return collect(found);
+}
+
+std::vector<SimilarMatch> SimilarityIndex::withinTolerance(const DesignParameters& params, double tolerance,
+                                                           const std::string& exclude) const {
+    float query[D], low[D], high[D];
+    features(params, query);
+    std::fill_n(low, D, -std::numeric_limits<float>::infinity());
+    std::fill_n(high, D, std::numeric_limits<float>::infinity());
+    DesignMetrics metrics = CarDesign::evaluate(params);
+    const int speed = static_cast<int>(SimilarityFeature::SPEED), cost = static_cast<int>(SimilarityFeature::COST);
+    low[speed] = normalize(speed, metrics.speed * (1.0 - tolerance));
+    high[speed] = normalize(speed, metrics.speed * (1.0 + tolerance));
+    low[cost] = normalize(cost, metrics.attributes.cost * (1.0 - tolerance));
+    high[cost] = normalize(cost, metrics.attributes.cost * (1.0 + tolerance));
+
+    auto excluded = positions.find(exclude);
+    uint32_t skip = excluded != positions.end() ? excluded->second : UINT32_MAX;
+    std::vector<Found> found;
+    auto visit = [&](size_t point) {
+        if (point != skip) found.push_back({distanceSquared(points.data() + point * D, query), static_cast<uint32_t>(point)});
+    };
+    const Tree tree{points.data(), live.data(), splitDims.data()};
+    searchBox(tree, 0, treeSize, low, high, visit);
+    for (size_t point = treeSize; point < live.size(); point += LEAF_SIZE) {
+        searchBox(tree, point, std::min(point + LEAF_SIZE, live.size()), low, high, visit);
+    }
+    return collect(found);
+}
@@ -0,0 +1,73 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include "CarDesign.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Feature dimensions, each scaled to [0, 1] over what the catalogs allow.
+enum class SimilarityFeature {
+    FRONT_WING_AERO, REAR_WING_AERO, DIFFUSER_AERO, SIDEPODS_AERO,
+    SPEED, FUEL, COST, MASS,
+    COUNT
+};
+
+const int SIMILARITY_DIMS = static_cast<int>(SimilarityFeature::COUNT);
+
+struct SimilarMatch {
+    std::string name;
+    float distance{0.0f};  // Euclidean, in normalized feature space
+    float speed{0.0f};
+    float fuelConsumption{0.0f};
+    float cost{0.0f};
+};
+
+// k-d tree over normalized design features for nearest-neighbour and range
+// queries. The tree is an implicit median split over a point array: node
+// [begin, end) keeps its split point at the middle, with the dimension of
+// widest spread recorded for that slot, down to leaves of LEAF_SIZE points.
+// Upserts append to a pending tail that queries scan linearly and removals
+// leave tombstones; the tree is rebuilt, in parallel, once either grows too
+// large. Not thread-safe.
+class SimilarityIndex {
+public:
+    static constexpr size_t LEAF_SIZE = 16;
+
+    void build(const std::vector<std::string>& names, const std::vector<DesignParameters>& params, size_t threads = 0);
+    void upsert(const std::string& name, const DesignParameters& params);
+    void remove(const std::string& name);
+    size_t size() const { return positions.size(); }
+
+    // The k designs closest to params, nearest first, leaving out `exclude`.
+    std::vector<SimilarMatch> nearest(const DesignParameters& params, size_t k, const std::string& exclude = "") const;
+    // Every design within radius of params, nearest first.
+    std::vector<SimilarMatch> withinRadius(const DesignParameters& params, float radius) const;
+    // Designs whose speed and cost are both within a relative tolerance
+    // (0.02 for 2%) of those of params, nearest first.
+    std::vector<SimilarMatch> withinTolerance(const DesignParameters& params, double tolerance, const std::string& exclude = "") const;
+
+    static void features(const DesignParameters& params, float* out);
+
+private:
+    void rebuild(size_t threads = 0);
+    void buildRange(size_t begin, size_t end);
+    // Puts the median of [begin, end) along its widest dimension at the
+    // middle slot and returns that slot.
+    size_t splitRange(size_t begin, size_t end);
+    std::vector<SimilarMatch> collect(std::vector<std::pair<float, uint32_t>>& found) const;
+
+    std::vector<float> points;         // SIMILARITY_DIMS floats per point
+    std::vector<std::string> names;    // per point
+    std::vector<uint8_t> live;         // per point; 0 for tombstones
+    std::vector<uint8_t> splitDims;    // per point, for tree slots that split a node
+    std::vector<uint32_t> order;       // build scratch
+    std::unordered_map<std::string, uint32_t> positions;
+    size_t treeSize{0};                // points [0, treeSize) form the tree, the rest are pending
+    size_t tombstones{0};
+};
+
+#endif
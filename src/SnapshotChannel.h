@@ -0,0 +1,60 @@
+#ifndef SNAPSHOTCHANNEL_H
+#define SNAPSHOTCHANNEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// Triple buffer handing immutable snapshots from one writer thread to one
+// reader thread. Neither side ever blocks: the writer fills its private slot
+// and swaps it with the shared middle slot; the reader swaps the middle slot
+// into its own only when something new was published. The reader never sees
+// a half-written snapshot and never frees one, so a render loop pays one
+// atomic exchange per update however fast the writer publishes.
+//
+// Slots are reused, so a writer that clears and refills writeBuffer() in
+// place stops allocating once capacities settle. Published contents may be
+// two generations old when they come back to the writer.
+template <typename T>
+class SnapshotChannel {
+public:
+    SnapshotChannel() = default;
+    SnapshotChannel(const SnapshotChannel&) = delete;
+    SnapshotChannel& operator=(const SnapshotChannel&) = delete;
+
+    // Writer side.
+    T& writeBuffer() { return slots[backIndex].value; }
+    void publish() {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+    void publish(T value) {
+        writeBuffer() = std::move(value);
+        publish();
+    }
+
+    // Reader side. The reference stays valid until the next call to read().
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return slots[frontIndex].value;
+    }
+    bool hasUpdate() const { return (middle.load(std::memory_order_relaxed) & FRESH) != 0; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    Slot slots[3];
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t backIndex{0};   // writer only
+    alignas(64) uint8_t frontIndex{2};  // reader only
+};
+
+#endif
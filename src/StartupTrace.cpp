@@ -0,0 +1,25 @@
+#include "StartupTrace.h"
+#include <cstdio>
+
+StartupTrace::StartupTrace() : start(Clock::now()), phaseStart(start) {}
+
+void StartupTrace::mark(const std::string& phase) {
+    auto now = Clock::now();
+    phases.push_back({phase, std::chrono::duration<double, std::milli>(now - phaseStart).count()});
+    phaseStart = now;
+}
+
+double StartupTrace::elapsedMillis() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void StartupTrace::report(std::ostream& out) const {
+    char line[128];
+    out << "Startup phases:\n";
+    for (const auto& phase : phases) {
+        std::snprintf(line, sizeof(line), "  %-24s %8.2f ms\n", phase.name.c_str(), phase.millis);
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "  %-24s %8.2f ms\n", "total", std::chrono::duration<double, std::milli>(phaseStart - start).count());
+    out << line << std::flush;
+}
@@ -0,0 +1,31 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times consecutive startup phases from construction to the first frame.
+class StartupTrace {
+public:
+    StartupTrace();
+
+    // Ends the current phase under the given name.
+    void mark(const std::string& phase);
+    double elapsedMillis() const;
+    void report(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Phase {
+        std::string name;
+        double millis;
+    };
+
+    Clock::time_point start;
+    Clock::time_point phaseStart;
+    std::vector<Phase> phases;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "TaskRuntime.h"
+#include "CpuTopology.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+ThreadPoolExecutor::ThreadPoolExecutor(size_t threadCount, bool pinWorkers) {
+    for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i) {
+        workers.emplace_back(&ThreadPoolExecutor::workerLoop, this, i, pinWorkers);
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    shutdown();
+}
+
+void ThreadPoolExecutor::post(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopping) {
+            queue.push_back(std::move(work));
+            available.notify_one();
+            return;
+        }
+    }
+    work();
+}
+
+void ThreadPoolExecutor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPoolExecutor::workerLoop(size_t index, bool pin) {
+    // The render thread keeps worker slot 0 to itself.
+    if (pin) CpuTopology::pinWorker(index + 1);
+    while (true) {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            work = std::move(queue.front());
+            queue.pop_front();
+        }
+        work();
+    }
+}
+
+void ThreadPoolExecutor::parallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)>& work) {
+    if (count == 0) return;
+    // Helpers may start after the loop is over, so the state they share
+    // outlives the call; work itself is only touched for a claimed item.
+    struct Loop {
+        size_t count{0};
+        const std::function<void(size_t)>* work{nullptr};
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> settled{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->count = count;
+    loop->work = &work;
+    auto run = [](Loop& state) {
+        while (true) {
+            size_t index = state.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= state.count) return;
+            if (!state.failed.load(std::memory_order_relaxed)) {
+                try {
+                    (*state.work)(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    if (!state.error) state.error = std::current_exception();
+                    state.failed = true;
+                }
+            }
+            if (state.settled.fetch_add(1, std::memory_order_acq_rel) + 1 == state.count) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.done.notify_all();
+            }
+        }
+    };
+    size_t helpers = maxThreads > 0 ? maxThreads - 1 : workers.size();
+    helpers = std::min({helpers, workers.size(), count - 1});
+    for (size_t i = 0; i < helpers; ++i) post([loop, run]() { run(*loop); });
+    run(*loop);
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&]() { return loop->settled.load(std::memory_order_acquire) == count; });
+    if (loop->error) std::rethrow_exception(loop->error);
+}
+
+ThreadPoolExecutor& ThreadPoolExecutor::shared() {
+    static ThreadPoolExecutor pool(std::max(1u, std::thread::hardware_concurrency()) - 1, true);
+    return pool;
+}
+
+void UiExecutor::post(std::function<void()> work) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(work));
+}
+
+thread_local const UiExecutor* UiExecutor::pumping = nullptr;
+
+size_t UiExecutor::pump() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.swap(queue);
+    }
+    size_t count = running.size();
+    const UiExecutor* outer = pumping;
+    pumping = this;
+    for (auto& work : running) {
+        try {
+            work();
+        } catch (const std::exception& e) {
+            std::cerr << "UI task failed: " << e.what() << std::endl;
+        }
+    }
+    pumping = outer;
+    running.clear();
+    return count;
+}
+
+TaskRuntime::TaskRuntime() : ioPool(1) {}
+
+TaskRuntime::~TaskRuntime() {
+    shutdown();
+}
+
+void TaskRuntime::spawn(Task<void> task, std::function<void(const std::string&)> onError) {
+    running.fetch_add(1, std::memory_order_relaxed);
+    runDetached(std::move(task), uiQueue, running, std::move(onError));
+}
+
+TaskDetail::Detached TaskRuntime::runDetached(Task<void> task, UiExecutor& ui, std::atomic<size_t>& running,
+                                              std::function<void(const std::string&)> onError) {
+    std::string message;
+    bool failed = true;
+    try {
+        co_await std::move(task);
+        failed = false;
+    } catch (const TaskCancelled&) {
+        failed = false;
+    } catch (const std::exception& e) {
+        message = e.what();
+    } catch (...) {
+        message = "Unknown error";
+    }
+    if (failed && onError) ui.post([onError = std::move(onError), message]() { onError(message); });
+    running.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskRuntime::shutdown() {
+    if (stopped) return;
+    stopped = true;
+    // Anything posted to the stopped I/O pool runs inline. The compute pool
+    // is shared and keeps running, so wait for the flows themselves, pumping
+    // the UI queue for those hopping back to it.
+    ioPool.shutdown();
+    while (true) {
+        bool idle = running.load(std::memory_order_acquire) == 0;
+        if (uiQueue.pump() > 0) continue;
+        if (idle) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
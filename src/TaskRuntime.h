@@ -0,0 +1,296 @@
+#ifndef TASKRUNTIME_H
+#define TASKRUNTIME_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Small coroutine runtime for work started from the UI.
+//
+// A flow is a Task<T> coroutine that moves between executors with
+// `co_await resumeOn(executor)`: file access on io(), number crunching on
+// compute(), and UI state updates back on ui(), which the render loop pumps
+// once per frame. Flows read as sequential code but never block a frame.
+//
+//     Task<DesignParameters> loadFlow(TaskRuntime& runtime, std::string name) {
+//         co_await resumeOn(runtime.io());
+//         CarDesign design;
+//         design.loadFromFile(name);
+//         co_await resumeOn(runtime.ui());
+//         co_return design.getParameters();
+//     }
+
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void post(std::function<void()> work) = 0;
+};
+
+// Fixed set of worker threads draining one FIFO queue. A single-threaded
+// pool runs its work strictly in posting order. After shutdown(), posted
+// work runs inline on the posting thread. With pinWorkers each worker pins
+// itself through CpuTopology::pinWorker when pinning is on.
+class ThreadPoolExecutor : public Executor {
+public:
+    explicit ThreadPoolExecutor(size_t threadCount, bool pinWorkers = false);
+    ~ThreadPoolExecutor() override;
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    void post(std::function<void()> work) override;
+    // Finishes the queued work and joins the workers.
+    void shutdown();
+    size_t threadCount() const { return workers.size(); }
+
+    // Runs work(i) for every i in [0, count) on the calling thread and up to
+    // maxThreads - 1 of the pool's workers (0 for all of them). The caller
+    // takes items too, so this is safe from one of the pool's own workers
+    // even when the others are busy. After the first exception no new items
+    // start; it is rethrown once the running ones have finished.
+    void parallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)>& work);
+
+    // The process-wide compute pool: a pinned worker for every CPU but the
+    // one the main thread keeps. TaskRuntime::compute() and the bulk loops
+    // all run here, so work started from a worker never adds threads.
+    static ThreadPoolExecutor& shared();
+
+private:
+    void workerLoop(size_t index, bool pin);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::function<void()>> queue;
+    bool stopping{false};
+};
+
+// Queue drained by the thread that calls pump(), i.e. the render loop.
+class UiExecutor : public Executor {
+public:
+    void post(std::function<void()> work) override;
+    // Runs the work queued before the call. Work it posts waits for the next pump.
+    size_t pump();
+    // True while the calling thread is inside pump().
+    bool isPumping() const { return pumping == this; }
+
+private:
+    static thread_local const UiExecutor* pumping;
+    std::mutex mutex;
+    std::vector<std::function<void()>> queue;
+    std::vector<std::function<void()>> running;
+};
+
+class TaskCancelled : public std::runtime_error {
+public:
+    TaskCancelled() : std::runtime_error("Operation cancelled") {}
+};
+
+class CancellationToken {
+public:
+    CancellationToken() = default;
+    bool isCancelled() const { return flag && flag->load(std::memory_order_acquire); }
+    void throwIfCancelled() const {
+        if (isCancelled()) throw TaskCancelled();
+    }
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<std::atomic<bool>> flag) : flag(std::move(flag)) {}
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// Owner side of a cancellation flag. Replace the source to start a new
+// generation of work; tokens handed out earlier stay cancelled.
+class CancellationSource {
+public:
+    CancellationSource() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+    CancellationToken token() const { return CancellationToken(flag); }
+    void cancel() { flag->store(true, std::memory_order_release); }
+    bool isCancelled() const { return flag->load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// Suspends the coroutine and resumes it on executor. Throws TaskCancelled on
+// resumption if token was cancelled meanwhile.
+struct ResumeOn {
+    Executor& executor;
+    CancellationToken token;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        executor.post([handle]() { handle.resume(); });
+    }
+    void await_resume() const { token.throwIfCancelled(); }
+};
+
+inline ResumeOn resumeOn(Executor& executor, CancellationToken token = CancellationToken()) {
+    return ResumeOn{executor, std::move(token)};
+}
+
+template <typename T = void>
+class Task;
+
+namespace TaskDetail {
+
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+        auto continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+    void rethrowIfFailed() const {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    T takeResult() {
+        rethrowIfFailed();
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() const noexcept {}
+    void takeResult() const { rethrowIfFailed(); }
+};
+
+// Self-destroying coroutine that owns a spawned task.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+}
+
+// Lazily started coroutine producing a T. Awaiting it starts it on the
+// current thread and resumes the awaiter wherever the task finishes.
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskDetail::Promise<T>;
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    T await_resume() { return handle.promise().takeResult(); }
+
+private:
+    friend promise_type;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+Task<T> TaskDetail::Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskDetail::Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// The executors behind UI-driven flows: the shared compute pool, a single
+// I/O thread so disk work stays in submission order, and the UI queue. Not
+// copyable; create one per application.
+class TaskRuntime {
+public:
+    TaskRuntime();
+    ~TaskRuntime();
+    TaskRuntime(const TaskRuntime&) = delete;
+    TaskRuntime& operator=(const TaskRuntime&) = delete;
+
+    ThreadPoolExecutor& compute() { return ThreadPoolExecutor::shared(); }
+    Executor& io() { return ioPool; }
+    Executor& ui() { return uiQueue; }
+    // Call once per frame from the render loop.
+    size_t pumpUi() { return uiQueue.pump(); }
+
+    // Starts task on the calling thread. Its result or error message is
+    // delivered on the UI thread; cancelled tasks report nothing.
+    template <typename T, typename OnSuccess>
+        requires(!std::is_void_v<T>)
+    void spawn(Task<T> task, OnSuccess onSuccess, std::function<void(const std::string&)> onError = {});
+    void spawn(Task<void> task, std::function<void(const std::string&)> onError = {});
+
+    // Lets in-flight flows run to completion, then stops the I/O pool.
+    void shutdown();
+
+private:
+    static TaskDetail::Detached runDetached(Task<void> task, UiExecutor& ui, std::atomic<size_t>& running,
+                                            std::function<void(const std::string&)> onError);
+    template <typename T, typename OnSuccess>
+    static Task<void> deliver(Task<T> task, UiExecutor& ui, OnSuccess onSuccess);
+
+    ThreadPoolExecutor ioPool;
+    UiExecutor uiQueue;
+    std::atomic<size_t> running{0};  // spawned flows not yet finished
+    bool stopped{false};
+};
+
+template <typename T, typename OnSuccess>
+Task<void> TaskRuntime::deliver(Task<T> task, UiExecutor& ui, OnSuccess onSuccess) {
+    T result = co_await std::move(task);
+    if (!ui.isPumping()) co_await resumeOn(ui);
+    onSuccess(std::move(result));
+}
+
+template <typename T, typename OnSuccess>
+    requires(!std::is_void_v<T>)
+void TaskRuntime::spawn(Task<T> task, OnSuccess onSuccess, std::function<void(const std::string&)> onError) {
+    spawn(deliver(std::move(task), uiQueue, std::move(onSuccess)), std::move(onError));
+}
+
+#endif
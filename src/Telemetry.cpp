@@ -0,0 +1,161 @@
+#include "Telemetry.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+TelemetrySample TelemetrySample::fromMetrics(double time, const DesignMetrics& metrics) {
+    TelemetrySample sample;
+    sample.time = time;
+    sample.values[static_cast<int>(TelemetryMetric::SPEED)] = static_cast<float>(metrics.speed);
+    sample.values[static_cast<int>(TelemetryMetric::FUEL)] = static_cast<float>(metrics.fuelConsumption);
+    sample.values[static_cast<int>(TelemetryMetric::DRAG)] = static_cast<float>(metrics.attributes.drag);
+    sample.values[static_cast<int>(TelemetryMetric::MASS)] = static_cast<float>(metrics.attributes.mass);
+    sample.values[static_cast<int>(TelemetryMetric::COST)] = static_cast<float>(metrics.attributes.cost);
+    return sample;
+}
+
+TelemetryRing::TelemetryRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    slots = std::make_unique<Slot[]>(size);
+    mask = size - 1;
+}
+
+void TelemetryRing::push(const TelemetrySample& sample) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    // Orders the previous head store before the overwrite below, so a
+    // reader that sees any of the new values also sees the old head.
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot& slot = slots[index & mask];
+    slot.time.store(sample.time, std::memory_order_relaxed);
+    for (int i = 0; i < TELEMETRY_METRIC_COUNT; ++i) slot.values[i].store(sample.values[i], std::memory_order_relaxed);
+    head.store(index + 1, std::memory_order_release);
+}
+
+uint64_t TelemetryRing::copyRange(uint64_t begin, uint64_t end, std::vector<TelemetrySample>& out) const {
+    size_t base = out.size();
+    out.resize(base + (end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots[index & mask];
+        TelemetrySample& sample = out[base + (index - begin)];
+        sample.time = slot.time.load(std::memory_order_relaxed);
+        for (int i = 0; i < TELEMETRY_METRIC_COUNT; ++i) sample.values[i] = slot.values[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // The writer may be overwriting the slot of (head - capacity) right now.
+    uint64_t after = head.load(std::memory_order_relaxed);
+    uint64_t firstValid = after + 1 > capacity() ? after + 1 - capacity() : 0;
+    if (firstValid > begin) {
+        size_t lost = static_cast<size_t>(std::min(firstValid, end) - begin);
+        out.erase(out.begin() + base, out.begin() + base + lost);
+    }
+    return std::clamp(firstValid, begin, end);
+}
+
+void TelemetryRing::copyLatest(std::vector<TelemetrySample>& out, size_t maxCount) const {
+    out.clear();
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t available = std::min<uint64_t>({end, capacity() - 1, maxCount});
+    copyRange(end - available, end, out);
+}
+
+void TelemetryRing::copyWindow(std::vector<TelemetrySample>& out, double fromTime) const {
+    out.clear();
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t low = end - std::min<uint64_t>(end, capacity() - 1), high = end;
+    // Binary search for the first sample in the window. A slot overwritten
+    // meanwhile holds a newer time and only steers the search towards older
+    // samples; copyRange drops the overwritten ones.
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (slots[middle & mask].time.load(std::memory_order_relaxed) < fromTime) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    copyRange(low, end, out);
+}
+
+uint64_t TelemetryRing::readSince(uint64_t& cursor, std::vector<TelemetrySample>& out) const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = std::max(cursor, end > capacity() - 1 ? end - (capacity() - 1) : 0);
+    uint64_t lost = copyRange(begin, end, out) - cursor;
+    cursor = end;
+    return lost;
+}
+
+void downsampleLttb(const TelemetrySample* samples, size_t count, TelemetryMetric metric, size_t threshold,
+                    std::vector<PlotPoint>& out) {
+    out.clear();
+    if (count == 0) return;
+    auto pointAt = [&](size_t i) { return PlotPoint{samples[i].time, samples[i].get(metric)}; };
+    if (threshold == 0 || threshold >= count) {
+        for (size_t i = 0; i < count; ++i) out.push_back(pointAt(i));
+        return;
+    }
+    if (threshold < 3) {
+        out.push_back(pointAt(0));
+        if (threshold == 2) out.push_back(pointAt(count - 1));
+        return;
+    }
+
+    out.reserve(threshold);
+    out.push_back(pointAt(0));
+    // Interior buckets share the samples between the first and the last.
+    double bucketSize = static_cast<double>(count - 2) / (threshold - 2);
+    size_t selected = 0;
+    for (size_t bucket = 0; bucket < threshold - 2; ++bucket) {
+        size_t begin = static_cast<size_t>(bucket * bucketSize) + 1;
+        size_t end = std::min(static_cast<size_t>((bucket + 1) * bucketSize) + 1, count - 1);
+
+        // Average of the next bucket (for the last one, the final sample) as the third vertex.
+        size_t nextBegin = end;
+        size_t nextEnd = std::min(static_cast<size_t>((bucket + 2) * bucketSize) + 1, count);
+        double averageX = 0.0, averageY = 0.0;
+        for (size_t i = nextBegin; i < nextEnd; ++i) {
+            averageX += samples[i].time;
+            averageY += samples[i].get(metric);
+        }
+        size_t nextCount = std::max<size_t>(nextEnd - nextBegin, 1);
+        averageX /= nextCount;
+        averageY /= nextCount;
+
+        double anchorX = samples[selected].time;
+        double anchorY = samples[selected].get(metric);
+        double bestArea = -1.0;
+        size_t best = begin;
+        for (size_t i = begin; i < end; ++i) {
+            double area = std::abs((anchorX - averageX) * (samples[i].get(metric) - anchorY) -
+                                   (anchorX - samples[i].time) * (averageY - anchorY));
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        out.push_back(pointAt(best));
+        selected = best;
+    }
+    out.push_back(pointAt(count - 1));
+}
+
+const char* telemetryMetricName(TelemetryMetric metric) {
+    static const char* names[TELEMETRY_METRIC_COUNT] = {"speed", "fuel", "drag", "mass", "cost"};
+    int index = static_cast<int>(metric);
+    return index >= 0 && index < TELEMETRY_METRIC_COUNT ? names[index] : "";
+}
+
+void writeTelemetryCsv(std::ostream& out, const std::vector<TelemetrySample>& samples, size_t maxPoints) {
+    out << "metric,time,value\n";
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);  // timestamps need more than six digits
+    std::vector<PlotPoint> points;
+    for (int m = 0; m < TELEMETRY_METRIC_COUNT; ++m) {
+        TelemetryMetric metric = static_cast<TelemetryMetric>(m);
+        downsampleLttb(samples.data(), samples.size(), metric, maxPoints, points);
+        for (const auto& point : points) out << telemetryMetricName(metric) << ',' << point.x << ',' << point.y << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,80 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "CarDesign.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+enum class TelemetryMetric { SPEED, FUEL, DRAG, MASS, COST, COUNT };
+
+const int TELEMETRY_METRIC_COUNT = static_cast<int>(TelemetryMetric::COUNT);
+
+struct TelemetrySample {
+    double time{0.0};
+    float values[TELEMETRY_METRIC_COUNT]{};
+
+    float get(TelemetryMetric metric) const { return values[static_cast<int>(metric)]; }
+    static TelemetrySample fromMetrics(double time, const DesignMetrics& metrics);
+};
+
+struct PlotPoint {
+    double x;
+    float y;
+};
+
+// Fixed-capacity history of samples. One writer pushes without ever
+// waiting; once full, the oldest samples are overwritten. Readers on any
+// thread copy a consistent window: slots are written with relaxed atomics
+// and a copy is trimmed to the samples the writer cannot have touched
+// meanwhile, so readers never block the writer or see torn samples.
+class TelemetryRing {
+public:
+    explicit TelemetryRing(size_t capacity = 1 << 18);  // rounded up to a power of two
+    TelemetryRing(const TelemetryRing&) = delete;
+    TelemetryRing& operator=(const TelemetryRing&) = delete;
+
+    // Writer side.
+    void push(const TelemetrySample& sample);
+
+    size_t capacity() const { return mask + 1; }
+    uint64_t written() const { return head.load(std::memory_order_acquire); }
+    // Replaces out with up to maxCount of the newest samples, oldest first.
+    void copyLatest(std::vector<TelemetrySample>& out, size_t maxCount) const;
+    // Replaces out with the retained samples at or after fromTime. Assumes
+    // sample times never decrease, so only the window itself is copied.
+    void copyWindow(std::vector<TelemetrySample>& out, double fromTime) const;
+    // Appends everything pushed since cursor and advances it. Returns the
+    // number of samples overwritten before this reader got to them.
+    uint64_t readSince(uint64_t& cursor, std::vector<TelemetrySample>& out) const;
+
+private:
+    struct Slot {
+        std::atomic<double> time;
+        std::atomic<float> values[TELEMETRY_METRIC_COUNT];
+    };
+
+    // Copies [begin, end) minus any prefix overwritten meanwhile; returns where the copy starts.
+    uint64_t copyRange(uint64_t begin, uint64_t end, std::vector<TelemetrySample>& out) const;
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<uint64_t> head{0};
+};
+
+// Largest-Triangle-Three-Buckets downsampling of one metric to at most
+// threshold points. Keeps the first and last sample and, per bucket, the
+// sample spanning the largest triangle with its neighbours, which preserves
+// peaks and the visual shape. Runs in one pass over the input; a threshold
+// of 0 keeps every sample.
+void downsampleLttb(const TelemetrySample* samples, size_t count, TelemetryMetric metric, size_t threshold,
+                    std::vector<PlotPoint>& out);
+
+const char* telemetryMetricName(TelemetryMetric metric);
+// Writes "metric,time,value" rows, each metric downsampled to maxPoints.
+void writeTelemetryCsv(std::ostream& out, const std::vector<TelemetrySample>& samples, size_t maxPoints);
+
+#endif
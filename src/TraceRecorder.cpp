@@ -0,0 +1,175 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::active{false};
+const std::chrono::steady_clock::time_point TraceRecorder::origin = std::chrono::steady_clock::now();
+
+namespace {
+
+struct TraceSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> begin{0};
+    std::atomic<int64_t> end{0};
+};
+
+// Written only by its thread. Readers copy slots and then check `writing`
+// to discard any slot the owner may have overwritten during the copy.
+struct ThreadBuffer {
+    std::atomic<uint64_t> head{0};     // zones published
+    std::atomic<uint64_t> writing{0};  // head + 1 while a slot is being written
+    TraceSlot slots[TraceRecorder::RING_EVENTS];
+    // Guarded by the registry mutex.
+    int tid{0};
+    std::string threadName;
+    uint64_t clearedAt{0};
+    bool inUse{true};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();  // never destroyed: threads may record during exit
+    return *instance;
+}
+
+thread_local std::string currentThreadName;
+
+// Claims a buffer on a thread's first zone and hands it back when the thread
+// exits, so short-lived threads reuse tracks instead of growing the registry.
+struct BufferLease {
+    ThreadBuffer* buffer{nullptr};
+
+    ThreadBuffer* get() {
+        if (buffer) return buffer;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& candidate : reg.buffers) {
+            if (!candidate->inUse) {
+                buffer = candidate.get();
+                break;
+            }
+        }
+        if (!buffer) {
+            reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = reg.buffers.back().get();
+            buffer->tid = static_cast<int>(reg.buffers.size());
+        }
+        buffer->inUse = true;
+        buffer->threadName = currentThreadName;
+        return buffer;
+    }
+
+    ~BufferLease() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer->inUse = false;
+    }
+};
+
+thread_local BufferLease lease;
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}
+
+void TraceRecorder::record(const char* name, int64_t beginNs, int64_t endNs) {
+    ThreadBuffer* buffer = lease.get();
+    uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    buffer->writing.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceSlot& slot = buffer->slots[index % RING_EVENTS];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin.store(beginNs, std::memory_order_relaxed);
+    slot.end.store(endNs, std::memory_order_relaxed);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const std::string& name) {
+    currentThreadName = name;
+    if (!lease.buffer) return;
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    lease.buffer->threadName = name;
+}
+
+void TraceRecorder::clear() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& buffer : reg.buffers) buffer->clearedAt = buffer->head.load(std::memory_order_acquire);
+}
+
+size_t TraceRecorder::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Failed to open trace file: " + path);
+
+    struct Zone {
+        const char* name;
+        int64_t begin;
+        int64_t end;
+    };
+    std::vector<Zone> zones;
+    size_t written = 0;
+    bool anyEvents = false;
+    char line[256];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = std::max(head > RING_EVENTS ? head - RING_EVENTS : 0, buffer->clearedAt);
+        zones.clear();
+        for (uint64_t index = first; index < head; ++index) {
+            const TraceSlot& slot = buffer->slots[index % RING_EVENTS];
+            zones.push_back({slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+                             slot.end.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t writing = buffer->writing.load(std::memory_order_relaxed);
+        uint64_t stable = writing > RING_EVENTS ? writing - RING_EVENTS : 0;
+        size_t skip = stable > first ? static_cast<size_t>(std::min(stable, head) - first) : 0;
+
+        if (skip < zones.size() || !buffer->threadName.empty()) {
+            out << (anyEvents ? ",\n" : "\n");
+            anyEvents = true;
+            std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                          buffer->tid);
+            out << line;
+            writeJsonString(out, buffer->threadName.empty() ? "thread " + std::to_string(buffer->tid) : buffer->threadName);
+            out << "}}";
+        }
+        for (size_t i = skip; i < zones.size(); ++i) {
+            out << ",\n{\"name\":";
+            writeJsonString(out, zones[i].name);
+            // Timestamps are in microseconds.
+            std::snprintf(line, sizeof(line), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid,
+                          zones[i].begin / 1000.0, (zones[i].end - zones[i].begin) / 1000.0);
+            out << line;
+            ++written;
+        }
+    }
+    out << "\n]}\n";
+    if (!out) throw std::runtime_error("Failed to write trace file: " + path);
+    return written;
+}
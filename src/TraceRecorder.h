@@ -0,0 +1,64 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones for hot paths, exported in the Chrome trace-event JSON
+// format (chrome://tracing, Perfetto). Each thread appends finished zones to
+// its own ring of RING_EVENTS slots without taking a lock; once a ring is
+// full the oldest zones are overwritten. Recording is off until enabled, and
+// building without F1_TRACING removes every TRACE_ZONE.
+class TraceRecorder {
+public:
+    static constexpr size_t RING_EVENTS = 1 << 15;
+
+    static void setEnabled(bool enabled) { active.store(enabled, std::memory_order_relaxed); }
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    // Nanoseconds since the first use of the recorder.
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+    // name must outlive the recorder, e.g. a string literal.
+    static void record(const char* name, int64_t beginNs, int64_t endNs);
+    // Labels the calling thread's track in exported traces.
+    static void setThreadName(const std::string& name);
+
+    // Drops every zone recorded so far.
+    static void clear();
+    // Writes the zones still held by the rings; returns how many were written.
+    static size_t writeChromeTrace(const std::string& path);
+
+private:
+    static std::atomic<bool> active;
+    static const std::chrono::steady_clock::time_point origin;
+};
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name)
+        : name(TraceRecorder::enabled() ? name : nullptr), begin(this->name ? TraceRecorder::now() : 0) {}
+    ~TraceZone() {
+        if (name) TraceRecorder::record(name, begin, TraceRecorder::now());
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* name;
+    int64_t begin;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#ifdef F1_TRACING
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_ZONE(name) ((void)0)
+#endif
+
+#endif
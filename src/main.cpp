@@ -8,8 +8,22 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
+#include <cfloat>
+#include <cstdio>
 #include "CarDesign.h"
 #include "ConfigurationManager.h"
+#include "CpuTopology.h"
+#include "DesignHeatmap.h"
+#include "DesignHistory.h"
+#include "DesignOptimizer.h"
+#include "DesignVersionHistory.h"
+#include "HeadlessCommands.h"
+#include "LibraryEvaluator.h"
+#include "LibraryIndex.h"
+#include "StartupTrace.h"
+#include "TaskRuntime.h"
+#include "Telemetry.h"
+#include "TraceRecorder.h"
 
 void setupImGuiStyle() {
     ImGuiStyle& style = ImGui::GetStyle();
@@ -64,31 +78,211 @@ void drawGauge(ImDrawList* drawList, ImVec2 center, float radius, float value, f
     ImGui::Text("%s: %.2f", label, value);
 }
 
-#include "ConfigurationManager.h" // Add include for ensureDesignsDirectory
+// Line plot of already downsampled points, scaled to their own range.
+void drawTelemetryPlot(const char* label, const std::vector<PlotPoint>& points, ImVec2 size) {
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), ImColor(0.10f, 0.10f, 0.14f));
+    if (points.empty()) {
+        ImGui::Text("%s: no samples", label);
+        ImGui::Dummy(ImVec2(size.x, size.y - ImGui::GetTextLineHeight()));
+        return;
+    }
+    float minY = points.front().y, maxY = points.front().y;
+    for (const auto& point : points) {
+        minY = std::min(minY, point.y);
+        maxY = std::max(maxY, point.y);
+    }
+    double minX = points.front().x, spanX = std::max(points.back().x - minX, 1e-6);
+    float spanY = std::max(maxY - minY, 1e-6f);
+    std::vector<ImVec2> vertices;
+    vertices.reserve(points.size());
+    for (const auto& point : points) {
+        vertices.emplace_back(origin.x + static_cast<float>((point.x - minX) / spanX) * size.x,
+                              origin.y + size.y - 4.0f - (point.y - minY) / spanY * (size.y - 8.0f));
+    }
+    drawList->AddPolyline(vertices.data(), static_cast<int>(vertices.size()), ImColor(0.90f, 0.30f, 0.30f), 0, 1.5f);
+    ImGui::Text("%s: %.2f (%.2f - %.2f)", label, points.back().y, minY, maxY);
+    ImGui::Dummy(ImVec2(size.x, size.y - ImGui::GetTextLineHeight()));
+}
 
-int main() {
-    std::cout << "Application started." << std::endl;
+// Plot-ready series for the Live Telemetry panel.
+struct TelemetryPlots {
+    uint64_t written{0};  // ring position the series were built from
+    int window{-1};
+    size_t samples{0};
+    std::vector<PlotPoint> series[TELEMETRY_METRIC_COUNT];
+};
 
-    try {
-        // Initialize ConfigurationManager and ensure designs directory exists
-        ConfigurationManager configManager;
-        configManager.ensureDesignsDirectory();
+// Flows started from the UI; spawn() delivers their results on the UI thread.
+Task<std::vector<std::string>> listDesignsFlow(TaskRuntime& runtime) {
+    co_await resumeOn(runtime.io());
+    co_return ConfigurationManager::getDesignFiles();
+}
+
+Task<DesignParameters> loadDesignFlow(TaskRuntime& runtime, std::string name, CancellationToken token) {
+    co_await resumeOn(runtime.io(), token);
+    CarDesign design;
+    design.loadFromFile(name);
+    co_await resumeOn(runtime.ui(), token);
+    co_return design.getParameters();
+}
+
+// Validates, backs up, saves and versions the design off the render thread.
+// Resolves to false when the design exists and overwriting was not confirmed.
+Task<bool> saveDesignFlow(TaskRuntime& runtime, std::string name, DesignParameters params, bool overwriteConfirmed) {
+    auto [isValid, error] = CarDesign::validateDesignName(name);
+    if (!isValid) {
+        throw std::invalid_argument(error);
+    }
+    co_await resumeOn(runtime.io());
+    if (!overwriteConfirmed && ConfigurationManager::designExists(name)) co_return false;
+    CarDesign design;
+    design.setParameters(params);
+    ConfigurationManager::saveDesign(design, name);
+    co_return true;
+}
+
+// Decodes every saved version of a design for the Version History panel.
+Task<std::vector<DesignVersion>> loadVersionsFlow(TaskRuntime& runtime, std::string name, CancellationToken token) {
+    co_await resumeOn(runtime.io(), token);
+    std::vector<DesignVersion> versions = DesignVersionHistory(name).getVersions();
+    co_await resumeOn(runtime.ui(), token);
+    co_return versions;
+}
+
+// The library index is only touched from the I/O thread, next to the saves that update it.
+Task<std::vector<IndexRow>> findDesignsFlow(TaskRuntime& runtime, IndexQuery query) {
+    co_await resumeOn(runtime.io());
+    co_return ConfigurationManager::getLibraryIndex().query(query);
+}
+
+// The designs most like a saved one: the k nearest, or with a non-negative
+// tolerance every design within it on both speed and cost.
+Task<std::vector<SimilarMatch>> similarDesignsFlow(TaskRuntime& runtime, std::string name, size_t k, double tolerance) {
+    co_await resumeOn(runtime.io());
+    LibraryIndex& index = ConfigurationManager::getLibraryIndex();
+    const DesignParameters* params = index.find(name);
+    if (!params) throw std::runtime_error("Design is not in the library index: " + name);
+    SimilarityIndex& similarity = index.similarityIndex();
+    co_return tolerance >= 0.0 ? similarity.withinTolerance(*params, tolerance, name) : similarity.nearest(*params, k, name);
+}
+
+// Copies the visible window out of the ring and downsamples each metric to
+// about one point per pixel, so the frame only draws a bounded polyline.
+Task<TelemetryPlots> downsampleTelemetryFlow(TaskRuntime& runtime, const TelemetryRing& ring, int window,
+                                             double fromTime, size_t points) {
+    co_await resumeOn(runtime.compute());
+    TelemetryPlots plots;
+    plots.written = ring.written();
+    plots.window = window;
+    std::vector<TelemetrySample> samples;
+    ring.copyWindow(samples, fromTime);
+    plots.samples = samples.size();
+    for (int m = 0; m < TELEMETRY_METRIC_COUNT; ++m) {
+        downsampleLttb(samples.data(), samples.size(), static_cast<TelemetryMetric>(m), points, plots.series[m]);
+    }
+    co_return plots;
+}
+
+// Refines one band of a heatmap pass by pass on the compute pool, handing
+// each finished pass to onPass on the UI thread. band starts out holding the
+// coarsest pass. Cancelling token drops the passes still to come.
+Task<void> refineHeatmapBandFlow(TaskRuntime& runtime, std::shared_ptr<const DesignHeatmap> heatmap, int rowBegin, int rowEnd,
+                                 std::vector<float> band, CancellationToken token,
+                                 std::function<void(int, const std::vector<float>&)> onPass) {
+    for (int step = DesignHeatmap::COARSEST_STEP / 2; step >= 1; step /= 2) {
+        co_await resumeOn(runtime.compute(), token);
+        heatmap->refine(step, rowBegin, rowEnd, band.data());
+        co_await resumeOn(runtime.ui(), token);
+        onPass(step, band);
+    }
+}
+
+// Runs the optimizer on the compute pool one migration interval at a time,
+// handing each interval's progress and the best designs so far to onProgress
+// on the UI thread. Cancelling token stops it at the next interval.
+Task<void> optimizeDesignsFlow(TaskRuntime& runtime, OptimizerConfig config, size_t keep, CancellationToken token,
+                               std::function<void(const std::vector<OptimizerProgress>&, std::vector<OptimizerCandidate>)> onProgress) {
+    co_await resumeOn(runtime.compute(), token);
+    // Islands evolve on the same pool this flow runs on, with this worker taking a share.
+    DesignOptimizer optimizer(config, runtime.compute());
+    while (!optimizer.finished()) {
+        std::vector<OptimizerProgress> progress = optimizer.advance();
+        std::vector<OptimizerCandidate> best = optimizer.best(keep);
+        co_await resumeOn(runtime.ui(), token);
+        onProgress(progress, std::move(best));
+        co_await resumeOn(runtime.compute(), token);
+    }
+}
+
+// Saves designs as prefix1, prefix2, ... through the same path as the Save button.
+Task<size_t> saveNumberedDesignsFlow(TaskRuntime& runtime, std::string prefix, std::vector<DesignParameters> designs) {
+    for (size_t i = 0; i < designs.size(); ++i) {
+        auto [isValid, error] = CarDesign::validateDesignName(prefix + std::to_string(i + 1));
+        if (!isValid) throw std::invalid_argument(error);
+    }
+    co_await resumeOn(runtime.io());
+    CarDesign design;
+    for (size_t i = 0; i < designs.size(); ++i) {
+        design.setParameters(designs[i]);
+        ConfigurationManager::saveDesign(design, prefix + std::to_string(i + 1));
+    }
+    co_return designs.size();
+}
 
-        // Log the number of design files
-        int designCount = configManager.countDesignFiles("designs");
-        std::cout << "Number of design files: " << designCount << std::endl;
+#include "ConfigurationManager.h" // Add include for ensureDesignsDirectory
 
-        std::cout << "Starting main()" << std::endl;
+int main(int argc, char** argv) {
+    // --trace FILE records trace zones for the whole run, GUI or command, and writes them to FILE at exit.
+    // --pin-threads pins parallel workers to CPUs spread over the NUMA nodes.
+    std::string tracePath = "trace.json";
+    bool traceAtExit = false;
+    while (argc > 1) {
+        std::string option = argv[1];
+        if (option == "--trace" && argc > 2) {
+            tracePath = argv[2];
+            traceAtExit = true;
+            TraceRecorder::setEnabled(true);
+            argv[2] = argv[0];
+            argv += 2;
+            argc -= 2;
+        } else if (option == "--pin-threads") {
+            CpuTopology::setPinning(true);
+            argv[1] = argv[0];
+            argv += 1;
+            argc -= 1;
+        } else {
+            break;
+        }
+    }
+    TraceRecorder::setThreadName("main");
+    if (argc > 1) {
+        int status = runHeadlessCommand(argc, argv);
+        if (traceAtExit) {
+            try {
+                std::cout << "Wrote " << TraceRecorder::writeChromeTrace(tracePath) << " trace zones to " << tracePath << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "An error occurred: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+        return status;
+    }
+    std::cout << "Application started." << std::endl;
+    StartupTrace startupTrace;
 
-        // Ensure designs directory exists before starting
+    try {
+        // The library itself is restored and counted in the background by LibraryEvaluator.
         ConfigurationManager::ensureDesignsDirectory();
-        std::cout << "Ensured designs directory" << std::endl;
+        startupTrace.mark("designs directory");
 
         if (!glfwInit()) {
             std::cerr << "Failed to initialize GLFW" << std::endl;
             return -1;
         }
         std::cout << "GLFW initialized" << std::endl;
+        startupTrace.mark("glfw");
 
         GLFWwindow* window = glfwCreateWindow(1600, 900, "Formula One Car Designer", nullptr, nullptr);
         if (!window) {
@@ -97,6 +291,7 @@ int main() {
             return -1;
         }
         std::cout << "GLFW window created" << std::endl;
+        startupTrace.mark("window");
 
         glfwMakeContextCurrent(window);
         glfwSwapInterval(1);
@@ -110,6 +305,7 @@ int main() {
         setupImGuiStyle();
         ImGui_ImplGlfw_InitForOpenGL(window, true);
         ImGui_ImplOpenGL3_Init("#version 130");
+        startupTrace.mark("imgui");
 
         enum class Section { WELCOME, MAIN_MENU, DESIGN, LOAD, COMPARE };
         Section currentSection = Section::WELCOME;
@@ -118,8 +314,51 @@ int main() {
         std::vector<std::string> designFiles;
         int selections[4] = {0, 0, 0, 0};
         float aeroAdjustments[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        DesignHistory designHistory;
+        bool historyEditActive = false;
+        // Metrics of the edited design, sampled every frame the editor is open.
+        TelemetryRing designTelemetry;
+        TelemetryPlots telemetryPlots;
+        bool telemetryJobActive = false;
+        int telemetryWindow = 0;
+        // Heatmap tab: the UI copy of the image, refined in bands by background flows.
+        HeatmapSpec heatmapRequest;
+        std::shared_ptr<const DesignHeatmap> heatmap;
+        CancellationSource heatmapCancel;
+        std::vector<float> heatmapValues;
+        std::vector<uint32_t> heatmapPixels;
+        std::vector<int> heatmapBandSteps;  // finest pass each band has delivered
+        bool heatmapDirty = false;
+        GLuint heatmapTexture = 0;
+        // Optimizer tab: convergence curves and the best designs, streamed in by optimizeDesignsFlow.
+        float optimizerWeights[3] = {1.0f, 0.0f, 0.0f};
+        int optimizerGenerations = 200;
+        int optimizerSeed = 1;
+        CancellationSource optimizerCancel;
+        bool optimizerRunning = false;
+        std::vector<float> optimizerBestCurve, optimizerMeanCurve;
+        std::vector<OptimizerCandidate> optimizerResults;
+        char optimizerPrefix[48] = "Optimized";
+        std::string optimizerStatus;
+        auto applyHistoryState = [&](const DesignParameters& state) {
+            for (int i = 0; i < 4; ++i) {
+                selections[i] = state.parts[i];
+                aeroAdjustments[i] = static_cast<float>(state.aero[i]);
+            }
+        };
         char filename[128] = "";
         int selectedDesignIndex = -1;
+        int selectedVersion = -1;
+        // Versions of historyName, decoded once on the I/O thread while the Version History header is open.
+        std::string historyName;
+        std::vector<DesignVersion> historyVersions;
+        std::string historyError;
+        bool historyLoading = false;
+        CancellationSource historyCancel;
+        float findMaxCost = 60000.0f, findMaxFuel = 13.0f, findMinSpeed = 0.0f;
+        int findLimit = 20;
+        std::vector<IndexRow> findResults;
+        std::vector<SimilarMatch> similarResults;
         int compareDesignIndex1 = -1, compareDesignIndex2 = -1;
         bool showError = false, showConfirm = false, showSaveSuccess = false;
         std::string errorMessage;
@@ -131,12 +370,96 @@ int main() {
         float welcomeTime = 0.0f;
         float saveProgress = 0.0f;
 
+        // Loads and evaluates the saved library off the render thread.
+        LibraryEvaluator libraryEvaluator;
+        libraryEvaluator.start();
+        bool firstFrameReported = false, catalogReported = false;
+
+        // Declared after the state its flows update, so it settles them before that state goes away.
+        TaskRuntime taskRuntime;
+        startupTrace.mark("background workers");
+        CancellationSource loadCancel, compareCancel1, compareCancel2;
+        std::string loadedDesignName, loadedCompareName1, loadedCompareName2;
+        bool saveInProgress = false;
+        auto reportError = [&](const std::string& message) {
+            showError = true;
+            errorMessage = message;
+            designsDirError = message.find("designs") != std::string::npos;
+        };
+        // The catalog snapshot replaces a directory scan once the first one is available.
+        auto refreshDesignFiles = [&]() {
+            const LibrarySnapshot& library = libraryEvaluator.latest();
+            if (library.generation > 0) {
+                designFiles = library.names;
+                return;
+            }
+            designFiles.clear();
+            taskRuntime.spawn(listDesignsFlow(taskRuntime),
+                              [&](std::vector<std::string> files) { designFiles = std::move(files); }, reportError);
+        };
+        // Drops the cached versions after the selection changes or a save.
+        auto resetVersionHistory = [&]() {
+            historyCancel.cancel();
+            historyCancel = CancellationSource();
+            historyName.clear();
+            historyVersions.clear();
+            historyError.clear();
+            historyLoading = false;
+            selectedVersion = -1;
+        };
+
+        // Loads name into target; a newer load into the same target cancels this one.
+        auto startLoad = [&](const std::string& name, CarDesign& target, CancellationSource& source, std::string& loadedName) {
+            source.cancel();
+            source = CancellationSource();
+            loadedName.clear();
+            taskRuntime.spawn(loadDesignFlow(taskRuntime, name, source.token()),
+                              [&target, &loadedName, &showError, name](DesignParameters params) {
+                                  target.setParameters(params);
+                                  loadedName = name;
+                                  showError = false;
+                              },
+                              reportError);
+        };
+
+        // Shows the coarsest pass of spec straight away and refines it in bands of rows on the compute pool.
+        auto startHeatmap = [&](const HeatmapSpec& spec) {
+            heatmapCancel.cancel();
+            heatmapCancel = CancellationSource();
+            auto next = std::make_shared<const DesignHeatmap>(spec);
+            heatmap = next;
+            heatmapValues.assign(static_cast<size_t>(spec.width) * spec.height, 0.0f);
+            next->refine(DesignHeatmap::COARSEST_STEP, 0, spec.height, heatmapValues.data());
+            heatmapDirty = true;
+            const int bandRows = 2 * DesignHeatmap::COARSEST_STEP;
+            heatmapBandSteps.assign((spec.height + bandRows - 1) / bandRows, DesignHeatmap::COARSEST_STEP);
+            for (size_t band = 0; band < heatmapBandSteps.size(); ++band) {
+                int rowBegin = static_cast<int>(band) * bandRows;
+                int rowEnd = std::min(rowBegin + bandRows, spec.height);
+                std::vector<float> coarse(heatmapValues.begin() + static_cast<size_t>(rowBegin) * spec.width,
+                                          heatmapValues.begin() + static_cast<size_t>(rowEnd) * spec.width);
+                taskRuntime.spawn(refineHeatmapBandFlow(taskRuntime, next, rowBegin, rowEnd, std::move(coarse), heatmapCancel.token(),
+                                                        [&, band, offset = static_cast<size_t>(rowBegin) * spec.width](
+                                                            int step, const std::vector<float>& values) {
+                                                            std::copy(values.begin(), values.end(), heatmapValues.begin() + offset);
+                                                            heatmapBandSteps[band] = step;
+                                                            heatmapDirty = true;
+                                                        }),
+                                  reportError);
+            }
+        };
+
         const char* designNames[] = {"Standard", "High Downforce", "Low Drag", "Balanced", "Experimental"};
         const char* diffuserNames[] = {"Standard", "Aggressive", "Minimal", "Balanced", "Experimental"};
         const char* sidepodsNames[] = {"Standard", "Compact", "Streamlined", "Balanced", "Experimental"};
 
+        bool traceRecording = TraceRecorder::enabled();
+        std::string traceStatus;
+
         while (!glfwWindowShouldClose(window)) {
+            TRACE_ZONE("frame");
             glfwPollEvents();
+            taskRuntime.pumpUi();
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
@@ -208,38 +531,28 @@ int main() {
                     currentSection = Section::DESIGN;
                     std::fill_n(selections, 4, 0);
                     std::fill_n(aeroAdjustments, 4, 1.0f);
+                    designHistory.reset(DesignParameters());
+                    historyEditActive = false;
                     filename[0] = '\0';
                     nameValidationMessage.clear();
                     isNameValid = false;
                     sectionAlpha = 0.0f;
                 }
                 if (ImGui::Button("Load Configuration", ImVec2(200, 50))) {
-                try {
-                    designFiles = ConfigurationManager::getDesignFiles();
+                    refreshDesignFiles();
                     currentSection = Section::LOAD;
                     selectedDesignIndex = -1;
                     sectionAlpha = 0.0f;
                     showError = false;
                     designsDirError = false;
-                } catch (const std::exception& e) {
-                    showError = true;
-                    errorMessage = e.what();
-                    designsDirError = std::string(e.what()).find("designs") != std::string::npos;
-                }
                 }
                 if (ImGui::Button("Compare Configurations", ImVec2(200, 50))) {
-                try {
-                    designFiles = ConfigurationManager::getDesignFiles();
+                    refreshDesignFiles();
                     currentSection = Section::COMPARE;
                     compareDesignIndex1 = compareDesignIndex2 = -1;
                     sectionAlpha = 0.0f;
                     showError = false;
                     designsDirError = false;
-                } catch (const std::exception& e) {
-                    showError = true;
-                    errorMessage = e.what();
-                    designsDirError = true;
-                }
                 }
                 if (ImGui::Button("Exit", ImVec2(200, 50))) glfwSetWindowShouldClose(window, true);
                 ImGui::EndChild();
@@ -256,16 +569,91 @@ int main() {
                     ImGui::TextWrapped("Design and compare Formula 1 car configurations with real-time metrics and visualizations.");
                     ImGui::Dummy(ImVec2(0, 20));
                     ImGui::Text("Quick Stats:");
-                    int designCount = 0;
-                    try {
-                        designCount = ConfigurationManager::countDesignFiles("designs");
-                    } catch (const std::exception& e) {
-                        designsDirError = true;
+                    const LibrarySnapshot& library = libraryEvaluator.latest();
+                    if (library.generation == 0) {
+                        ImGui::TextColored(ImVec4(0.6f, 0.6f, 1.0f, sectionAlpha), "Scanning saved designs...");
+                    } else {
+                        ImGui::TextColored(ImVec4(0.6f, 0.6f, 1.0f, sectionAlpha), "Total Designs Saved: %zu", library.names.size());
+                        if (library.fastest >= 0) {
+                            ImGui::Text("Fastest: %s (%.2f km/h)", library.names[library.fastest].c_str(), library.metrics[library.fastest].speed);
+                            ImGui::Text("Most Efficient: %s (%.2f L/100km)", library.names[library.mostEfficient].c_str(),
+                                        library.metrics[library.mostEfficient].fuelConsumption);
+                            ImGui::Text("Cheapest: %s ($%.2f)", library.names[library.cheapest].c_str(),
+                                        library.metrics[library.cheapest].attributes.cost);
+                            ImGui::Text("Pareto Front (speed, fuel, cost): %zu designs", library.pareto.size());
+                        }
+                        // Everything below comes precomputed with the snapshot, so it costs the same at any library size.
+                        const LibraryStats& stats = library.stats;
+                        if (stats.count() > 0 && ImGui::CollapsingHeader("Library Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
+                            const char* metricLabels[] = {"Speed (km/h)", "Fuel (L/100km)", "Cost ($)", "Mass (kg)"};
+                            if (ImGui::BeginTable("LibraryStatsTable", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+                                ImGui::TableSetupColumn("Metric");
+                                ImGui::TableSetupColumn("Mean");
+                                ImGui::TableSetupColumn("Std Dev");
+                                ImGui::TableSetupColumn("P10");
+                                ImGui::TableSetupColumn("Median");
+                                ImGui::TableSetupColumn("P90");
+                                ImGui::TableHeadersRow();
+                                for (int m = 0; m < STAT_METRIC_COUNT; ++m) {
+                                    const MetricSummary& summary = library.summaries[m];
+                                    ImGui::TableNextRow();
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%s", metricLabels[m]);
+                                    for (double value : {summary.mean, summary.stddev, summary.p10, summary.median, summary.p90}) {
+                                        ImGui::TableNextColumn();
+                                        ImGui::Text("%.2f", value);
+                                    }
+                                }
+                                ImGui::EndTable();
+                            }
+                            const char* partLabels[] = {"Front Wing", "Rear Wing", "Diffuser", "Sidepods"};
+                            const char* const* partDesignNames[] = {designNames, designNames, diffuserNames, sidepodsNames};
+                            for (int part = 0; part < 4; ++part) {
+                                std::string usage;
+                                for (int index = 0; index < 5; ++index) {
+                                    char entry[64];
+                                    std::snprintf(entry, sizeof(entry), "%s%s %.0f%%", index > 0 ? ", " : "", partDesignNames[part][index],
+                                                  100.0 * stats.partUsage(part, index) / stats.count());
+                                    usage += entry;
+                                }
+                                ImGui::Text("%s: %s", partLabels[part], usage.c_str());
+                            }
+                            ImGui::Text("Aero factor distribution, 0.5 to 1.5:");
+                            for (int part = 0; part < 4; ++part) {
+                                float bins[LibraryStats::AERO_BINS];
+                                for (int bin = 0; bin < LibraryStats::AERO_BINS; ++bin) bins[bin] = static_cast<float>(stats.aeroCount(part, bin));
+                                char overlay[64];
+                                std::snprintf(overlay, sizeof(overlay), "mean %.3f", stats.aeroMoments(part).mean);
+                                ImGui::PlotHistogram(partLabels[part], bins, LibraryStats::AERO_BINS, 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 40));
+                            }
+                        }
+                        if (library.skippedFiles > 0) {
+                            ImGui::TextColored(ImVec4(1, 0.6f, 0, sectionAlpha), "%d design files could not be read", library.skippedFiles);
+                        }
                     }
-                    ImGui::TextColored(ImVec4(0.6f, 0.6f, 1.0f, sectionAlpha), "Total Designs Saved: %d", designCount);
-                    if (designsDirError) {
+                    if (designsDirError || library.directoryError) {
                         ImGui::TextColored(ImVec4(1, 0, 0, sectionAlpha), "Warning: Unable to access designs directory");
                     }
+                    if (ImGui::CollapsingHeader("Performance Trace")) {
+                        if (ImGui::Checkbox("Record trace zones", &traceRecording)) TraceRecorder::setEnabled(traceRecording);
+                        ImGui::SameLine();
+                        if (ImGui::Button("Clear")) {
+                            TraceRecorder::clear();
+                            traceStatus.clear();
+                        }
+                        ImGui::SameLine();
+                        if (ImGui::Button("Export")) {
+                            try {
+                                traceStatus = "Wrote " + std::to_string(TraceRecorder::writeChromeTrace(tracePath)) + " zones to " + tracePath;
+                            } catch (const std::exception& e) {
+                                traceStatus = e.what();
+                            }
+                        }
+                        if (!traceStatus.empty()) ImGui::TextWrapped("%s", traceStatus.c_str());
+                        ImGui::Text("Design parsing: %zu arena allocations (%zu overflowed the arena), %zu global heap allocations",
+                                    library.allocations.arenaAllocations, library.allocations.overflowAllocations,
+                                    library.allocations.heapAllocations);
+                    }
                     ImGui::Dummy(ImVec2(0, 20));
                     drawCarSilhouette(ImGui::GetWindowDrawList(), ImVec2(ImGui::GetCursorScreenPos().x + 300, ImGui::GetCursorScreenPos().y + 100), 1.5f);
                     ImGui::PopStyleVar();
@@ -344,9 +732,243 @@ int main() {
                             ImGui::TextWrapped("Visual Representation:\n%s", previewDesign.getVisualRepresentation().c_str());
                             ImGui::EndTabItem();
                         }
+                        if (ImGui::BeginTabItem("Heatmap")) {
+                            const char* axisNames[] = {"Front Wing Aero", "Rear Wing Aero", "Diffuser Aero", "Sidepods Aero"};
+                            const char* metricNames[] = {"Speed", "Fuel", "Cost"};
+                            ImGui::Combo("X Axis##Heatmap", &heatmapRequest.xAxis, axisNames, IM_ARRAYSIZE(axisNames));
+                            ImGui::Combo("Y Axis##Heatmap", &heatmapRequest.yAxis, axisNames, IM_ARRAYSIZE(axisNames));
+                            int metric = static_cast<int>(heatmapRequest.metric);
+                            if (ImGui::Combo("Metric##Heatmap", &metric, metricNames, IM_ARRAYSIZE(metricNames))) {
+                                heatmapRequest.metric = static_cast<HeatmapMetric>(metric);
+                            }
+                            for (int i = 0; i < 4; ++i) {
+                                heatmapRequest.base.parts[i] = selections[i];
+                                // The factors on the axes are swept, so their sliders do not restart the image.
+                                bool onAxis = i == heatmapRequest.xAxis || i == heatmapRequest.yAxis;
+                                heatmapRequest.base.aero[i] = onAxis ? 1.0 : aeroAdjustments[i];
+                            }
+                            if (heatmapRequest.xAxis == heatmapRequest.yAxis) {
+                                ImGui::TextColored(ImVec4(1, 0, 0, 1), "Choose two different axes");
+                            } else {
+                                if (!heatmap || !(heatmap->spec() == heatmapRequest)) {
+                                    try {
+                                        startHeatmap(heatmapRequest);
+                                    } catch (const std::exception& e) {
+                                        showError = true;
+                                        errorMessage = e.what();
+                                    }
+                                }
+                                if (heatmapDirty && heatmap) {
+                                    const HeatmapSpec& spec = heatmap->spec();
+                                    heatmapPixels.resize(heatmapValues.size());
+                                    DesignHeatmap::colorize(heatmapValues.data(), heatmapValues.size(), heatmapPixels.data());
+                                    if (heatmapTexture == 0) {
+                                        glGenTextures(1, &heatmapTexture);
+                                        glBindTexture(GL_TEXTURE_2D, heatmapTexture);
+                                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                                        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spec.width, spec.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                                                     heatmapPixels.data());
+                                    } else {
+                                        glBindTexture(GL_TEXTURE_2D, heatmapTexture);
+                                        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, spec.width, spec.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                                                        heatmapPixels.data());
+                                    }
+                                    heatmapDirty = false;
+                                }
+                                if (heatmap) {
+                                    const HeatmapSpec& spec = heatmap->spec();
+                                    ImGui::Image((ImTextureID)(intptr_t)heatmapTexture, ImVec2(static_cast<float>(spec.width),
+                                                                                                static_cast<float>(spec.height)));
+                                    if (ImGui::IsItemHovered()) {
+                                        ImVec2 mouse = ImGui::GetMousePos(), origin = ImGui::GetItemRectMin();
+                                        int x = std::clamp(static_cast<int>(mouse.x - origin.x), 0, spec.width - 1);
+                                        int y = std::clamp(static_cast<int>(mouse.y - origin.y), 0, spec.height - 1);
+                                        ImGui::SetTooltip("%s %.3f, %s %.3f\n%s: %.2f", axisNames[spec.xAxis], heatmap->xValue(x),
+                                                          axisNames[spec.yAxis], heatmap->yValue(y), DesignHeatmap::metricName(spec.metric),
+                                                          heatmapValues[static_cast<size_t>(y) * spec.width + x]);
+                                    }
+                                    int coarsest = *std::max_element(heatmapBandSteps.begin(), heatmapBandSteps.end());
+                                    if (coarsest > 1) {
+                                        ImGui::Text("Refining: %dx%d pixel blocks", coarsest, coarsest);
+                                    } else {
+                                        ImGui::Text("Exact (%dx%d)", spec.width, spec.height);
+                                    }
+                                }
+                            }
+                            ImGui::EndTabItem();
+                        }
+                        if (ImGui::BeginTabItem("Optimizer")) {
+                            ImGui::BeginDisabled(optimizerRunning);
+                            ImGui::SliderFloat("Speed Weight", &optimizerWeights[0], 0.0f, 1.0f, "%.2f");
+                            ImGui::SliderFloat("Fuel Weight", &optimizerWeights[1], 0.0f, 1.0f, "%.2f");
+                            ImGui::SliderFloat("Cost Weight", &optimizerWeights[2], 0.0f, 1.0f, "%.2f");
+                            ImGui::SliderInt("Generations", &optimizerGenerations, 10, 2000);
+                            ImGui::InputInt("Seed", &optimizerSeed);
+                            ImGui::EndDisabled();
+                            if (!optimizerRunning && ImGui::Button("Run Optimizer")) {
+                                OptimizerConfig config;
+                                config.weights = {optimizerWeights[0], optimizerWeights[1], optimizerWeights[2]};
+                                config.generations = optimizerGenerations;
+                                config.seed = static_cast<uint64_t>(optimizerSeed);
+                                optimizerCancel = CancellationSource();
+                                optimizerRunning = true;
+                                optimizerBestCurve.clear();
+                                optimizerMeanCurve.clear();
+                                optimizerResults.clear();
+                                optimizerStatus.clear();
+                                taskRuntime.spawn(optimizeDesignsFlow(taskRuntime, config, 10, optimizerCancel.token(),
+                                                                      [&, generations = config.generations](
+                                                                          const std::vector<OptimizerProgress>& progress,
+                                                                          std::vector<OptimizerCandidate> best) {
+                                                                          for (const auto& record : progress) {
+                                                                              optimizerBestCurve.push_back(static_cast<float>(record.bestFitness));
+                                                                              optimizerMeanCurve.push_back(static_cast<float>(record.meanFitness));
+                                                                          }
+                                                                          optimizerResults = std::move(best);
+                                                                          if (progress.back().generation >= generations) optimizerRunning = false;
+                                                                      }),
+                                                  [&](const std::string& message) {
+                                                      optimizerRunning = false;
+                                                      reportError(message);
+                                                  });
+                            } else if (optimizerRunning && ImGui::Button("Stop")) {
+                                optimizerCancel.cancel();
+                                optimizerRunning = false;
+                            }
+                            if (!optimizerBestCurve.empty()) {
+                                ImGui::SameLine();
+                                ImGui::Text("Generation %zu of %d", optimizerBestCurve.size(), optimizerGenerations);
+                                ImGui::PlotLines("Best Fitness", optimizerBestCurve.data(), static_cast<int>(optimizerBestCurve.size()), 0,
+                                                 nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 80));
+                                ImGui::PlotLines("Mean Fitness", optimizerMeanCurve.data(), static_cast<int>(optimizerMeanCurve.size()), 0,
+                                                 nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 80));
+                            }
+                            if (!optimizerResults.empty() &&
+                                ImGui::BeginTable("OptimizerResults", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+                                ImGui::TableSetupColumn("Fitness");
+                                ImGui::TableSetupColumn("Parts");
+                                ImGui::TableSetupColumn("Aero");
+                                ImGui::TableSetupColumn("Speed");
+                                ImGui::TableSetupColumn("Fuel");
+                                ImGui::TableSetupColumn("Cost");
+                                ImGui::TableHeadersRow();
+                                for (size_t i = 0; i < optimizerResults.size(); ++i) {
+                                    const OptimizerCandidate& candidate = optimizerResults[i];
+                                    const DesignParameters& p = candidate.params;
+                                    ImGui::TableNextRow();
+                                    ImGui::TableNextColumn();
+                                    char label[48];
+                                    std::snprintf(label, sizeof(label), "%.4f##optimized%zu", candidate.fitness, i);
+                                    // Selecting a row loads it into the editor.
+                                    if (ImGui::Selectable(label, false, ImGuiSelectableFlags_SpanAllColumns)) applyHistoryState(p);
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%s / %s / %s / %s", designNames[p.parts[0]], designNames[p.parts[1]],
+                                                diffuserNames[p.parts[2]], sidepodsNames[p.parts[3]]);
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%.3f %.3f %.3f %.3f", p.aero[0], p.aero[1], p.aero[2], p.aero[3]);
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%.2f", candidate.metrics.speed);
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%.2f", candidate.metrics.fuelConsumption);
+                                    ImGui::TableNextColumn();
+                                    ImGui::Text("%.0f", candidate.metrics.attributes.cost);
+                                }
+                                ImGui::EndTable();
+                                ImGui::InputText("Name Prefix", optimizerPrefix, IM_ARRAYSIZE(optimizerPrefix));
+                                ImGui::SameLine();
+                                if (ImGui::Button("Save All")) {
+                                    std::vector<DesignParameters> designs;
+                                    for (const auto& candidate : optimizerResults) designs.push_back(candidate.params);
+                                    std::string prefix(optimizerPrefix);
+                                    taskRuntime.spawn(saveNumberedDesignsFlow(taskRuntime, prefix, std::move(designs)),
+                                                      [&, prefix](size_t saved) {
+                                                          libraryEvaluator.requestRefresh();
+                                                          resetVersionHistory();
+                                                          optimizerStatus = "Saved " + prefix + "1 to " + prefix + std::to_string(saved);
+                                                      },
+                                                      reportError);
+                                }
+                                if (!optimizerStatus.empty()) ImGui::Text("%s", optimizerStatus.c_str());
+                            }
+                            ImGui::EndTabItem();
+                        }
+                        if (ImGui::BeginTabItem("History")) {
+                            ImGui::BeginDisabled(!designHistory.canUndo());
+                            if (ImGui::Button("Undo (Ctrl+Z)")) applyHistoryState(designHistory.undo());
+                            ImGui::EndDisabled();
+                            ImGui::SameLine();
+                            ImGui::BeginDisabled(!designHistory.canRedo());
+                            if (ImGui::Button("Redo (Ctrl+Y)")) applyHistoryState(designHistory.redo());
+                            ImGui::EndDisabled();
+                            // The timeline runs along the current branch by depth, not node creation order.
+                            std::vector<size_t> branch = designHistory.currentBranch();
+                            int timelinePos = static_cast<int>(designHistory.depth(designHistory.currentNode()));
+                            if (ImGui::SliderInt("Timeline", &timelinePos, 0, static_cast<int>(branch.size()) - 1)) {
+                                applyHistoryState(designHistory.jumpTo(branch[static_cast<size_t>(timelinePos)]));
+                            }
+                            ImGui::Text("Steps: %zu, Memory: %.1f KB", designHistory.size(), designHistory.memoryUsage() / 1024.0);
+                            ImGui::Text("Variants:");
+                            ImGui::BeginChild("HistoryVariants", ImVec2(0, 200), true);
+                            for (size_t tip : designHistory.getBranchTips()) {
+                                std::string label = "Variant at step " + std::to_string(designHistory.depth(tip)) +
+                                                    "##" + std::to_string(tip);
+                                if (ImGui::Selectable(label.c_str(), designHistory.currentNode() == tip)) {
+                                    applyHistoryState(designHistory.jumpTo(tip));
+                                }
+                            }
+                            ImGui::EndChild();
+                            ImGui::EndTabItem();
+                        }
                         ImGui::EndTabBar();
                     }
 
+                    // Leave Ctrl+Z/Ctrl+Y to a focused text field's own undo.
+                    if (!io.WantTextInput && io.KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_Z) && designHistory.canUndo()) {
+                        applyHistoryState(designHistory.undo());
+                    } else if (!io.WantTextInput && io.KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_Y) && designHistory.canRedo()) {
+                        applyHistoryState(designHistory.redo());
+                    }
+                    // One history step per drag: keep coalescing while a widget stays active.
+                    DesignParameters editedState;
+                    for (int i = 0; i < 4; ++i) {
+                        editedState.parts[i] = selections[i];
+                        editedState.aero[i] = aeroAdjustments[i];
+                    }
+                    bool editActive = ImGui::IsAnyItemActive();
+                    designHistory.record(editedState, editActive && historyEditActive);
+                    historyEditActive = editActive;
+
+                    double now = glfwGetTime();
+                    designTelemetry.push(TelemetrySample::fromMetrics(now, CarDesign::evaluate(editedState)));
+                    if (ImGui::CollapsingHeader("Live Telemetry")) {
+                        const char* windowNames[] = {"Last 10 s", "Last 60 s", "Last 10 min", "All"};
+                        const double windowSeconds[] = {10.0, 60.0, 600.0, 0.0};
+                        ImGui::Combo("Window##Telemetry", &telemetryWindow, windowNames, IM_ARRAYSIZE(windowNames));
+                        ImVec2 plotSize(ImGui::GetContentRegionAvail().x, 70.0f);
+                        // One downsampling job at a time; the plots show the last finished one.
+                        if (!telemetryJobActive && (telemetryPlots.written != designTelemetry.written() ||
+                                                    telemetryPlots.window != telemetryWindow)) {
+                            double fromTime = windowSeconds[telemetryWindow] > 0.0 ? now - windowSeconds[telemetryWindow] : 0.0;
+                            size_t points = static_cast<size_t>(std::max(plotSize.x, 64.0f));
+                            telemetryJobActive = true;
+                            taskRuntime.spawn(downsampleTelemetryFlow(taskRuntime, designTelemetry, telemetryWindow, fromTime, points),
+                                              [&](TelemetryPlots plots) {
+                                                  telemetryPlots = std::move(plots);
+                                                  telemetryJobActive = false;
+                                              },
+                                              [&](const std::string& message) {
+                                                  telemetryJobActive = false;
+                                                  reportError(message);
+                                              });
+                        }
+                        ImGui::Text("%zu samples, %zu points per plot", telemetryPlots.samples, telemetryPlots.series[0].size());
+                        const char* plotLabels[] = {"Speed (km/h)", "Fuel (L/100km)", "Drag", "Mass (kg)", "Cost ($)"};
+                        for (int m = 0; m < TELEMETRY_METRIC_COUNT; ++m) {
+                            drawTelemetryPlot(plotLabels[m], telemetryPlots.series[m], plotSize);
+                        }
+                    }
+
                     ImGui::Separator();
                     std::string inputName(filename);
                     auto [valid, validationError] = CarDesign::validateDesignName(inputName);
@@ -363,39 +985,31 @@ int main() {
                     ImGui::PushStyleVar(ImGuiStyleVar_Alpha, sectionAlpha);
                     bool isHovered = ImGui::IsItemHovered();
                     float buttonScale = isHovered ? 1.1f : 1.0f;
-                    if (ImGui::Button("Save Design", ImVec2(150 * buttonScale, 40 * buttonScale))) {
-                        try {
-                            std::string cleanName(filename);
-                            cleanName.erase(std::remove_if(cleanName.begin(), cleanName.end(), 
-                                                           [](char c) { return c < 0 || c > 127; }), cleanName.end());
-                            auto [isValid, error] = CarDesign::validateDesignName(cleanName);
-                            if (!isValid) {
-                                throw std::invalid_argument(error);
-                            }
-                            if (ConfigurationManager::designExists(cleanName) && !overwriteConfirmed) {
-                                showConfirm = true;
-                            } else {
-                                ConfigurationManager::backupDesign(cleanName);
-                                currentDesign.setPartDesign(FRONT_WING, selections[0]);
-                                currentDesign.setPartDesign(REAR_WING, selections[1]);
-                                currentDesign.setPartDesign(DIFFUSER, selections[2]);
-                                currentDesign.setPartDesign(SIDEPODS, selections[3]);
-                                currentDesign.adjustAeroEfficiency(FRONT_WING, aeroAdjustments[0]);
-                                currentDesign.adjustAeroEfficiency(REAR_WING, aeroAdjustments[1]);
-                                currentDesign.adjustAeroEfficiency(DIFFUSER, aeroAdjustments[2]);
-                                currentDesign.adjustAeroEfficiency(SIDEPODS, aeroAdjustments[3]);
-                                currentDesign.saveToFile(cleanName);
-                                overwriteConfirmed = false;
-                                showError = false;
-                                showSaveSuccess = true;
-                                currentSection = Section::MAIN_MENU;
-                                sectionAlpha = 0.0f;
-                            }
-                        } catch (const std::exception& e) {
-                            showError = true;
-                            errorMessage = e.what();
-                            designsDirError = std::string(e.what()).find("designs") != std::string::npos;
-                        }
+                    if (ImGui::Button(saveInProgress ? "Saving..." : "Save Design", ImVec2(150 * buttonScale, 40 * buttonScale)) && !saveInProgress) {
+                        std::string cleanName(filename);
+                        cleanName.erase(std::remove_if(cleanName.begin(), cleanName.end(), 
+                                                       [](char c) { return c < 0 || c > 127; }), cleanName.end());
+                        saveInProgress = true;
+                        taskRuntime.spawn(saveDesignFlow(taskRuntime, cleanName, editedState, overwriteConfirmed),
+                                          [&, editedState](bool saved) {
+                                              saveInProgress = false;
+                                              if (!saved) {
+                                                  showConfirm = true;
+                                                  return;
+                                              }
+                                              currentDesign.setParameters(editedState);
+                                              libraryEvaluator.requestRefresh();
+                                              resetVersionHistory();
+                                              overwriteConfirmed = false;
+                                              showError = false;
+                                              showSaveSuccess = true;
+                                              currentSection = Section::MAIN_MENU;
+                                              sectionAlpha = 0.0f;
+                                          },
+                                          [&](const std::string& message) {
+                                              saveInProgress = false;
+                                              reportError(message);
+                                          });
                     }
                     ImGui::SameLine();
                     isHovered = ImGui::IsItemHovered();
@@ -417,18 +1031,41 @@ int main() {
                     for (size_t i = 0; i < designFiles.size(); ++i) {
                         if (ImGui::Selectable(designFiles[i].c_str(), selectedDesignIndex == i)) {
                             selectedDesignIndex = i;
-                            try {
-                                currentDesign.loadFromFile(designFiles[i]);
-                                showError = false;
-                            } catch (const std::exception& e) {
-                                showError = true;
-                                errorMessage = e.what();
-                                designsDirError = std::string(e.what()).find("designs") != std::string::npos;
-                            }
+                            resetVersionHistory();
+                            startLoad(designFiles[i], currentDesign, loadCancel, loadedDesignName);
                         }
                     }
                     ImGui::EndChild();
-                    if (selectedDesignIndex >= 0 && !showError) {
+                    if (ImGui::CollapsingHeader("Find Designs")) {
+                        ImGui::InputFloat("Max Cost", &findMaxCost, 1000.0f, 5000.0f, "%.0f");
+                        ImGui::InputFloat("Max Fuel", &findMaxFuel, 0.1f, 1.0f, "%.2f");
+                        ImGui::InputFloat("Min Speed", &findMinSpeed, 1.0f, 10.0f, "%.1f");
+                        ImGui::SliderInt("Results", &findLimit, 1, 100);
+                        if (ImGui::Button("Find Fastest")) {
+                            IndexQuery query;
+                            query.predicates.push_back({IndexColumn::COST, -INFINITY, findMaxCost});
+                            query.predicates.push_back({IndexColumn::FUEL, -INFINITY, findMaxFuel});
+                            query.predicates.push_back({IndexColumn::SPEED, findMinSpeed, INFINITY});
+                            query.limit = static_cast<size_t>(findLimit);
+                            taskRuntime.spawn(findDesignsFlow(taskRuntime, query),
+                                              [&](std::vector<IndexRow> rows) { findResults = std::move(rows); }, reportError);
+                        }
+                        for (const auto& row : findResults) {
+                            std::string label = row.name + "  (" + std::to_string(static_cast<int>(row.get(IndexColumn::SPEED))) + " km/h)";
+                            if (ImGui::Selectable(label.c_str())) {
+                                auto it = std::find(designFiles.begin(), designFiles.end(), row.name);
+                                if (it != designFiles.end()) {
+                                    selectedDesignIndex = static_cast<int>(it - designFiles.begin());
+                                    resetVersionHistory();
+                                    startLoad(row.name, currentDesign, loadCancel, loadedDesignName);
+                                }
+                            }
+                        }
+                    }
+                    if (selectedDesignIndex >= 0 && !showError && loadedDesignName != designFiles[selectedDesignIndex]) {
+                        ImGui::Separator();
+                        ImGui::Text("Loading %s...", designFiles[selectedDesignIndex].c_str());
+                    } else if (selectedDesignIndex >= 0 && !showError) {
                         ImGui::Separator();
                         ImGui::Text("Design: %s", designFiles[selectedDesignIndex].c_str());
                         drawCarSilhouette(ImGui::GetWindowDrawList(), ImVec2(ImGui::GetCursorScreenPos().x + 300, ImGui::GetCursorScreenPos().y + 150), 2.0f);
@@ -445,6 +1082,70 @@ int main() {
                         ImGui::TextColored(ImVec4(0.6f, 0.6f, 1.0f, sectionAlpha), "Total Mass: %.2f kg", attrs.mass);
                         ImGui::TextColored(ImVec4(0.6f, 0.6f, 1.0f, sectionAlpha), "Total Cost: $%.2f", attrs.cost);
                         ImGui::EndChild();
+                        if (ImGui::CollapsingHeader("Version History")) {
+                            const std::string& name = designFiles[selectedDesignIndex];
+                            if (historyName != name) {
+                                resetVersionHistory();
+                                historyName = name;
+                                historyLoading = true;
+                                taskRuntime.spawn(loadVersionsFlow(taskRuntime, name, historyCancel.token()),
+                                                  [&, name](std::vector<DesignVersion> versions) {
+                                                      if (historyName != name) return;
+                                                      historyVersions = std::move(versions);
+                                                      historyLoading = false;
+                                                  },
+                                                  [&, name](const std::string& message) {
+                                                      if (historyName != name) return;
+                                                      historyError = message;
+                                                      historyLoading = false;
+                                                  });
+                            }
+                            int versionCount = static_cast<int>(historyVersions.size());
+                            if (historyLoading) {
+                                ImGui::Text("Loading versions...");
+                            } else if (!historyError.empty()) {
+                                ImGui::TextColored(ImVec4(1, 0, 0, 1), "History unavailable: %s", historyError.c_str());
+                            } else {
+                                ImGui::Text("Saved versions: %d", versionCount);
+                            }
+                            if (!historyLoading && versionCount > 0) {
+                                if (selectedVersion < 0 || selectedVersion >= versionCount) selectedVersion = versionCount - 1;
+                                ImGui::SliderInt("Version", &selectedVersion, 0, versionCount - 1);
+                                auto changes = DesignVersionHistory::diff(historyVersions[selectedVersion].params,
+                                                                          currentDesign.getParameters());
+                                if (changes.empty()) {
+                                    ImGui::Text("Identical to the current file.");
+                                }
+                                for (const auto& change : changes) {
+                                    ImGui::Text("%s: %.2f -> %.2f", DesignVersionHistory::fieldName(change.field), change.before, change.after);
+                                }
+                            }
+                        }
+                        if (ImGui::CollapsingHeader("Similar Designs")) {
+                            const std::string& name = designFiles[selectedDesignIndex];
+                            if (ImGui::Button("10 Most Similar")) {
+                                taskRuntime.spawn(similarDesignsFlow(taskRuntime, name, 10, -1.0),
+                                                  [&](std::vector<SimilarMatch> matches) { similarResults = std::move(matches); }, reportError);
+                            }
+                            ImGui::SameLine();
+                            if (ImGui::Button("Within 2% Speed & Cost")) {
+                                taskRuntime.spawn(similarDesignsFlow(taskRuntime, name, 0, 0.02),
+                                                  [&](std::vector<SimilarMatch> matches) { similarResults = std::move(matches); }, reportError);
+                            }
+                            for (const auto& match : similarResults) {
+                                char label[160];
+                                std::snprintf(label, sizeof(label), "%s  (%.0f km/h, %.2f L/100km, $%.0f)", match.name.c_str(),
+                                              match.speed, match.fuelConsumption, match.cost);
+                                if (ImGui::Selectable(label)) {
+                                    auto it = std::find(designFiles.begin(), designFiles.end(), match.name);
+                                    if (it != designFiles.end()) {
+                                        selectedDesignIndex = static_cast<int>(it - designFiles.begin());
+                                        resetVersionHistory();
+                                        startLoad(match.name, currentDesign, loadCancel, loadedDesignName);
+                                    }
+                                }
+                            }
+                        }
                     }
                     bool isHovered = ImGui::IsItemHovered();
                     float buttonScale = isHovered ? 1.1f : 1.0f;
@@ -466,15 +1167,7 @@ int main() {
                         if (ImGui::Selectable((designFiles[i] + " (1)").c_str(), compareDesignIndex1 == i)) {
                             if (i != compareDesignIndex2) {
                                 compareDesignIndex1 = i;
-                                try {
-                                    compareDesign1 = CarDesign();
-                                    compareDesign1.loadFromFile(designFiles[i]);
-                                    showError = false;
-                                } catch (const std::exception& e) {
-                                    showError = true;
-                                    errorMessage = e.what();
-                                    designsDirError = std::string(e.what()).find("designs") != std::string::npos;
-                                }
+                                startLoad(designFiles[i], compareDesign1, compareCancel1, loadedCompareName1);
                             } else {
                                 showError = true;
                                 errorMessage = "Cannot select the same design twice";
@@ -488,15 +1181,7 @@ int main() {
                         if (ImGui::Selectable((designFiles[i] + " (2)").c_str(), compareDesignIndex2 == i)) {
                             if (i != compareDesignIndex1) {
                                 compareDesignIndex2 = i;
-                                try {
-                                    compareDesign2 = CarDesign();
-                                    compareDesign2.loadFromFile(designFiles[i]);
-                                    showError = false;
-                                } catch (const std::exception& e) {
-                                    showError = true;
-                                    errorMessage = e.what();
-                                    designsDirError = std::string(e.what()).find("designs") != std::string::npos;
-                                }
+                                startLoad(designFiles[i], compareDesign2, compareCancel2, loadedCompareName2);
                             } else {
                                 showError = true;
                                 errorMessage = "Cannot select the same design twice";
@@ -504,7 +1189,8 @@ int main() {
                         }
                     }
                     ImGui::EndChild();
-                    if (compareDesignIndex1 >= 0 && compareDesignIndex2 >= 0 && !showError) {
+                    if (compareDesignIndex1 >= 0 && compareDesignIndex2 >= 0 && !showError &&
+                        loadedCompareName1 == designFiles[compareDesignIndex1] && loadedCompareName2 == designFiles[compareDesignIndex2]) {
                         ImGui::Separator();
                         ImGui::Text("Comparison: %s vs %s", designFiles[compareDesignIndex1].c_str(), designFiles[compareDesignIndex2].c_str());
                         ImGui::Text("Design 1 Details:");
@@ -583,16 +1269,37 @@ int main() {
                 }
             }
 
-            ImGui::Render();
-            int display_w, display_h;
-            glfwGetFramebufferSize(window, &display_w, &display_h);
-            glViewport(0, 0, display_w, display_h);
-            glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            {
+                TRACE_ZONE("ImGui::Render");
+                ImGui::Render();
+                int display_w, display_h;
+                glfwGetFramebufferSize(window, &display_w, &display_h);
+                glViewport(0, 0, display_w, display_h);
+                glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
             glfwSwapBuffers(window);
+            if (!firstFrameReported) {
+                firstFrameReported = true;
+                startupTrace.mark("first frame");
+                startupTrace.report(std::cout);
+            }
+            if (!catalogReported && libraryEvaluator.latest().generation > 0) {
+                catalogReported = true;
+                const LibrarySnapshot& library = libraryEvaluator.latest();
+                std::cout << "Design catalog ready at " << startupTrace.elapsedMillis() << " ms: " << library.names.size()
+                          << " designs" << (library.fromCache ? " (restored from cache)" : "") << std::endl;
+            }
         }
 
+        optimizerCancel.cancel();
+        taskRuntime.shutdown();
+        libraryEvaluator.stop();
+        if (traceAtExit) {
+            std::cout << "Wrote " << TraceRecorder::writeChromeTrace(tracePath) << " trace zones to " << tracePath << std::endl;
+        }
+        if (heatmapTexture != 0) glDeleteTextures(1, &heatmapTexture);
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();